@@ -0,0 +1,104 @@
+/**
+ * The Forgotten Server - a free and open-source MMORPG server emulator
+ * Copyright (C) 2019  Mark Samman <mark.samman@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "otpch.h"
+
+#include "compression.h"
+#include "outputmessage.h"
+
+#include <zlib.h>
+
+namespace {
+
+std::atomic<uint64_t> totalPackets {0};
+std::atomic<uint64_t> totalBytesIn {0};
+std::atomic<uint64_t> totalBytesOut {0};
+std::atomic<uint64_t> totalMicroseconds {0};
+
+}
+
+PacketCompressor::PacketCompressor(int level) : stream(new z_stream())
+{
+	// negative window bits: raw deflate, no zlib header or trailer
+	initialized = deflateInit2(stream.get(), level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+	if (!initialized) {
+		std::cout << "[Warning - PacketCompressor] Failed to initialize deflate: " << (stream->msg ? stream->msg : "unknown error") << std::endl;
+	}
+}
+
+PacketCompressor::~PacketCompressor()
+{
+	if (initialized) {
+		deflateEnd(stream.get());
+	}
+}
+
+bool PacketCompressor::compress(OutputMessage& msg)
+{
+	if (!initialized) {
+		return false;
+	}
+
+	// an empty message can not come out smaller
+	OutputMessage::MsgSize_t length = msg.getLength();
+	if (length == 0) {
+		return false;
+	}
+
+	static thread_local std::array<uint8_t, NETWORKMESSAGE_MAXSIZE> output;
+
+	auto start = std::chrono::steady_clock::now();
+
+	deflateReset(stream.get());
+	stream->next_in = msg.getOutputBuffer();
+	stream->avail_in = length;
+	stream->next_out = output.data();
+	// anything that does not come out smaller is sent as it is
+	stream->avail_out = length - 1;
+
+	bool compressed = deflate(stream.get(), Z_FINISH) == Z_STREAM_END;
+	OutputMessage::MsgSize_t compressedLength = length;
+	if (compressed) {
+		compressedLength = static_cast<OutputMessage::MsgSize_t>(stream->total_out);
+		msg.replaceBody(output.data(), compressedLength);
+	}
+
+	uint64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+	stats.packets++;
+	stats.bytesIn += length;
+	stats.bytesOut += compressedLength;
+	stats.microseconds += elapsed;
+
+	totalPackets.fetch_add(1, std::memory_order_relaxed);
+	totalBytesIn.fetch_add(length, std::memory_order_relaxed);
+	totalBytesOut.fetch_add(compressedLength, std::memory_order_relaxed);
+	totalMicroseconds.fetch_add(elapsed, std::memory_order_relaxed);
+	return compressed;
+}
+
+CompressionStats PacketCompressor::getTotalStats()
+{
+	CompressionStats stats;
+	stats.packets = totalPackets.load(std::memory_order_relaxed);
+	stats.bytesIn = totalBytesIn.load(std::memory_order_relaxed);
+	stats.bytesOut = totalBytesOut.load(std::memory_order_relaxed);
+	stats.microseconds = totalMicroseconds.load(std::memory_order_relaxed);
+	return stats;
+}
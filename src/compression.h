@@ -0,0 +1,61 @@
+/**
+ * The Forgotten Server - a free and open-source MMORPG server emulator
+ * Copyright (C) 2019  Mark Samman <mark.samman@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FS_COMPRESSION_H_B1B308DA3E5848ECB151838725BE65C4
+#define FS_COMPRESSION_H_B1B308DA3E5848ECB151838725BE65C4
+
+class OutputMessage;
+struct z_stream_s;
+
+struct CompressionStats {
+	uint64_t packets = 0;
+	uint64_t bytesIn = 0;
+	uint64_t bytesOut = 0;
+	uint64_t microseconds = 0;
+};
+
+// Raw deflate of outgoing packet bodies. Each connection keeps its own zlib context and
+// resets it between packets instead of allocating a new one, every packet can be inflated
+// on its own. Used from the thread writing to the connection.
+class PacketCompressor
+{
+	public:
+		explicit PacketCompressor(int level);
+		~PacketCompressor();
+
+		// non-copyable
+		PacketCompressor(const PacketCompressor&) = delete;
+		PacketCompressor& operator=(const PacketCompressor&) = delete;
+
+		// replaces the body of msg with its compressed form, unless that would not be smaller
+		bool compress(OutputMessage& msg);
+
+		const CompressionStats& getStats() const {
+			return stats;
+		}
+
+		static CompressionStats getTotalStats();
+
+	private:
+		std::unique_ptr<z_stream_s> stream;
+		CompressionStats stats;
+		bool initialized = false;
+};
+
+#endif
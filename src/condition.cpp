@@ -129,7 +129,7 @@ void Condition::serialize(PropWriteStream& propWriteStream)
 void Condition::setTicks(int32_t newTicks)
 {
 	ticks = newTicks;
-	endTime = ticks + OTSYS_TIME();
+	endTime = ticks + OTSYS_CACHED_TIME();
 }
 
 bool Condition::executeCondition(Creature*, int32_t interval)
@@ -140,7 +140,7 @@ bool Condition::executeCondition(Creature*, int32_t interval)
 
 	//Not using set ticks here since it would reset endTime
 	ticks = std::max<int32_t>(0, ticks - interval);
-	return getEndTime() >= OTSYS_TIME();
+	return getEndTime() >= OTSYS_CACHED_TIME();
 }
 
 Condition* Condition::createCondition(ConditionId_t id, ConditionType_t type, int32_t ticks, int32_t param/* = 0*/, bool buff/* = false*/, uint32_t subId/* = 0*/)
@@ -255,7 +255,7 @@ Condition* Condition::createCondition(PropStream& propStream)
 bool Condition::startCondition(Creature*)
 {
 	if (ticks > 0) {
-		endTime = ticks + OTSYS_TIME();
+		endTime = ticks + OTSYS_CACHED_TIME();
 	}
 	return true;
 }
@@ -288,7 +288,7 @@ bool Condition::updateCondition(const Condition* addCondition)
 		return false;
 	}
 
-	if (addCondition->getTicks() >= 0 && getEndTime() > (OTSYS_TIME() + addCondition->getTicks())) {
+	if (addCondition->getTicks() >= 0 && getEndTime() > (OTSYS_CACHED_TIME() + addCondition->getTicks())) {
 		return false;
 	}
 
@@ -764,7 +764,7 @@ bool ConditionRegeneration::executeCondition(Creature* creature, int32_t interva
 				message.primary.color = TEXTCOLOR_MAYABLUE;
 				player->sendTextMessage(message);
 
-				SpectatorHashSet spectators;
+				SpectatorVec spectators;
 				g_game.map.getSpectators(spectators, player->getPosition(), false, true);
 				spectators.erase(player);
 				if (!spectators.empty()) {
@@ -795,7 +795,7 @@ bool ConditionRegeneration::executeCondition(Creature* creature, int32_t interva
 				message.primary.color = TEXTCOLOR_MAYABLUE;
 				player->sendTextMessage(message);
 
-				SpectatorHashSet spectators;
+				SpectatorVec spectators;
 				g_game.map.getSpectators(spectators, player->getPosition(), false, true);
 				spectators.erase(player);
 				if (!spectators.empty()) {
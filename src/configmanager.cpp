@@ -116,6 +116,9 @@ bool ConfigManager::load()
 		integer[GAME_PORT] = getGlobalNumber(L, "gameProtocolPort", 7172);
 		integer[LOGIN_PORT] = getGlobalNumber(L, "loginProtocolPort", 7171);
 		integer[STATUS_PORT] = getGlobalNumber(L, "statusProtocolPort", 7171);
+		integer[NETWORK_THREADS] = getGlobalNumber(L, "networkThreads", 1);
+		integer[JOB_THREADS] = getGlobalNumber(L, "jobThreads", 0);
+		integer[LOGIN_THREADS] = getGlobalNumber(L, "loginThreads", 2);
 
 		integer[MARKET_OFFER_DURATION] = getGlobalNumber(L, "marketOfferDuration", 30 * 24 * 60 * 60);
 	}
@@ -137,6 +140,10 @@ bool ConfigManager::load()
 	boolean[CLASSIC_ATTACK_SPEED] = getGlobalBoolean(L, "classicAttackSpeed", false);
 	boolean[SCRIPTS_CONSOLE_LOGS] = getGlobalBoolean(L, "showScriptsLogInConsole", true);
 	boolean[PLAYER_ITEMS_CACHE] = getGlobalBoolean(L, "playerItemsCache", false);
+	boolean[PACKET_COMPRESSION] = getGlobalBoolean(L, "packetCompression", false);
+	boolean[MAP_LEAF_INDEX] = getGlobalBoolean(L, "mapLeafIndex", true);
+	boolean[MAP_LAZY_LOADING] = getGlobalBoolean(L, "mapLazyLoading", false);
+	boolean[MAP_CACHE] = getGlobalBoolean(L, "mapCache", false);
 
 	string[DEFAULT_PRIORITY] = getGlobalString(L, "defaultPriority", "high");
 	string[SERVER_NAME] = getGlobalString(L, "serverName", "");
@@ -163,9 +170,15 @@ bool ConfigManager::load()
 	integer[EX_ACTIONS_DELAY_INTERVAL] = getGlobalNumber(L, "timeBetweenExActions", 1000);
 	integer[MAX_MESSAGEBUFFER] = getGlobalNumber(L, "maxMessageBuffer", 4);
 	integer[KICK_AFTER_MINUTES] = getGlobalNumber(L, "kickIdlePlayerAfterMinutes", 15);
+	integer[OUTPUT_FLUSH_SIZE] = getGlobalNumber(L, "outputFlushSize", 8192);
+	integer[OUTPUT_FLUSH_DELAY] = getGlobalNumber(L, "outputFlushDelay", 10);
+	integer[OUTPUT_FLUSH_DELAY_COMBAT] = getGlobalNumber(L, "outputFlushDelayCombat", 0);
+	integer[PACKET_COMPRESSION_LEVEL] = getGlobalNumber(L, "packetCompressionLevel", 6);
+	integer[PACKET_COMPRESSION_THRESHOLD] = std::max<int32_t>(1, getGlobalNumber(L, "packetCompressionThreshold", 512));
 	integer[PROTECTION_LEVEL] = getGlobalNumber(L, "protectionLevel", 1);
 	integer[DEATH_LOSE_PERCENT] = getGlobalNumber(L, "deathLosePercent", -1);
 	integer[STATUSQUERY_TIMEOUT] = getGlobalNumber(L, "statusTimeout", 5000);
+	integer[STATUS_CACHE_INTERVAL] = getGlobalNumber(L, "statusCacheInterval", 5000);
 	integer[FRAG_TIME] = getGlobalNumber(L, "timeToDecreaseFrags", 24 * 60 * 60 * 1000);
 	integer[WHITE_SKULL_TIME] = getGlobalNumber(L, "whiteSkullTime", 15 * 60 * 1000);
 	integer[STAIRHOP_DELAY] = getGlobalNumber(L, "stairJumpExhaustion", 2000);
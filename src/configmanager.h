@@ -43,6 +43,10 @@ class ConfigManager
 			CLASSIC_ATTACK_SPEED,
 			SCRIPTS_CONSOLE_LOGS,
 			PLAYER_ITEMS_CACHE,
+			PACKET_COMPRESSION,
+			MAP_LEAF_INDEX,
+			MAP_LAZY_LOADING,
+			MAP_CACHE,
 
 			LAST_BOOLEAN_CONFIG /* this must be the last one */
 		};
@@ -90,6 +94,7 @@ class ConfigManager
 			PROTECTION_LEVEL,
 			DEATH_LOSE_PERCENT,
 			STATUSQUERY_TIMEOUT,
+			STATUS_CACHE_INTERVAL,
 			FRAG_TIME,
 			WHITE_SKULL_TIME,
 			GAME_PORT,
@@ -101,6 +106,14 @@ class ConfigManager
 			MAX_MARKET_OFFERS_AT_A_TIME_PER_PLAYER,
 			EXP_FROM_PLAYERS_LEVEL_RANGE,
 			MAX_PACKETS_PER_SECOND,
+			NETWORK_THREADS,
+			JOB_THREADS,
+			LOGIN_THREADS,
+			OUTPUT_FLUSH_SIZE,
+			OUTPUT_FLUSH_DELAY,
+			OUTPUT_FLUSH_DELAY_COMBAT,
+			PACKET_COMPRESSION_LEVEL,
+			PACKET_COMPRESSION_THRESHOLD,
 
 			LAST_INTEGER_CONFIG /* this must be the last one */
 		};
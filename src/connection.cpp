@@ -21,6 +21,7 @@
 
 #include "configmanager.h"
 #include "connection.h"
+#include "loginqueue.h"
 #include "outputmessage.h"
 #include "protocol.h"
 #include "scheduler.h"
@@ -28,11 +29,11 @@
 
 extern ConfigManager g_config;
 
-Connection_ptr ConnectionManager::createConnection(boost::asio::io_service& io_service, ConstServicePort_ptr servicePort)
+Connection_ptr ConnectionManager::createConnection(boost::asio::io_service& io_service, NetworkThreadStats& threadStats, ConstServicePort_ptr servicePort)
 {
 	std::lock_guard<std::mutex> lockClass(connectionManagerLock);
 
-	auto connection = std::make_shared<Connection>(io_service, servicePort);
+	auto connection = std::make_shared<Connection>(io_service, threadStats, servicePort);
 	connections.insert(connection);
 	return connection;
 }
@@ -77,7 +78,7 @@ void Connection::close(bool force)
 			createTask(std::bind(&Protocol::release, protocol)));
 	}
 
-	if (messageQueue.empty() || force) {
+	if ((messageQueue.empty() && writingMessages.empty()) || force) {
 		closeSocket();
 	} else {
 		//will be closed by the destructor or onWriteOperation
@@ -102,6 +103,7 @@ void Connection::closeSocket()
 Connection::~Connection()
 {
 	closeSocket();
+	--threadStats.connections;
 }
 
 void Connection::accept(Protocol_ptr protocol)
@@ -186,6 +188,8 @@ void Connection::parsePacket(const boost::system::error_code& error)
 		return;
 	}
 
+	++threadStats.packetsReceived;
+
 	//Check packet checksum
 	uint32_t checksum;
 	int32_t len = msg.getLength() - msg.getBufferPosition() - NetworkMessage::CHECKSUM_LENGTH;
@@ -216,11 +220,34 @@ void Connection::parsePacket(const boost::system::error_code& error)
 			msg.skipBytes(1);    // Skip protocol ID
 		}
 
+		if (protocol->usesLoginQueue()) {
+			// reading stops until the handshake has been processed, so later packets keep their order
+			Connection_ptr connection = shared_from_this();
+			g_loginQueue.addTask([connection]() { connection->parseQueuedFirstMessage(); });
+			return;
+		}
+
 		protocol->onRecvFirstMessage(msg);
 	} else {
 		protocol->onRecvMessage(msg);    // Send the packet to the current protocol
 	}
 
+	readNextPacket();
+}
+
+void Connection::parseQueuedFirstMessage()
+{
+	std::lock_guard<std::recursive_mutex> lockClass(connectionLock);
+	if (connectionState != CONNECTION_STATE_OPEN) {
+		return;
+	}
+
+	protocol->onRecvFirstMessage(msg);
+	readNextPacket();
+}
+
+void Connection::readNextPacket()
+{
 	try {
 		readTimer.expires_from_now(boost::posix_time::seconds(CONNECTION_READ_TIMEOUT));
 		readTimer.async_wait(std::bind(&Connection::handleTimeout, std::weak_ptr<Connection>(shared_from_this()),
@@ -231,7 +258,7 @@ void Connection::parsePacket(const boost::system::error_code& error)
 		                        boost::asio::buffer(msg.getBuffer(), NetworkMessage::HEADER_LENGTH),
 		                        std::bind(&Connection::parseHeader, shared_from_this(), std::placeholders::_1));
 	} catch (boost::system::system_error& e) {
-		std::cout << "[Network error - Connection::parsePacket] " << e.what() << std::endl;
+		std::cout << "[Network error - Connection::readNextPacket] " << e.what() << std::endl;
 		close(FORCE_CLOSE);
 	}
 }
@@ -243,23 +270,39 @@ void Connection::send(const OutputMessage_ptr& msg)
 		return;
 	}
 
-	bool noPendingWrite = messageQueue.empty();
-	messageQueue.emplace_back(msg);
-	if (noPendingWrite) {
-		internalSend(msg);
+	if (messageQueue.full()) {
+		messageQueue.set_capacity(messageQueue.capacity() * 2);
+	}
+	messageQueue.push_back(msg);
+
+	if (writingMessages.empty()) {
+		internalSend();
 	}
 }
 
-void Connection::internalSend(const OutputMessage_ptr& msg)
+void Connection::internalSend()
 {
-	protocol->onSendMessage(msg);
+	// everything queued so far goes out in a single gathered write
+	writeBuffers.clear();
+	for (const OutputMessage_ptr& msg : messageQueue) {
+		protocol->onSendMessage(msg);
+		writeBuffers.emplace_back(msg->getOutputBuffer(), msg->getLength());
+		bytesSent += msg->getLength();
+	}
+
+	writingMessages.assign(messageQueue.begin(), messageQueue.end());
+	messageQueue.clear();
+
+	messagesSent += writingMessages.size();
+	threadStats.messagesSent += writingMessages.size();
+	++writeOperations;
+
 	try {
 		writeTimer.expires_from_now(boost::posix_time::seconds(CONNECTION_WRITE_TIMEOUT));
 		writeTimer.async_wait(std::bind(&Connection::handleTimeout, std::weak_ptr<Connection>(shared_from_this()),
 		                                     std::placeholders::_1));
 
-		boost::asio::async_write(socket,
-		                         boost::asio::buffer(msg->getOutputBuffer(), msg->getLength()),
+		boost::asio::async_write(socket, writeBuffers,
 		                         std::bind(&Connection::onWriteOperation, shared_from_this(), std::placeholders::_1));
 	} catch (boost::system::system_error& e) {
 		std::cout << "[Network error - Connection::internalSend] " << e.what() << std::endl;
@@ -281,11 +324,29 @@ uint32_t Connection::getIP()
 	return htonl(endpoint.address().to_v4().to_ulong());
 }
 
+uint64_t Connection::getBytesSent()
+{
+	std::lock_guard<std::recursive_mutex> lockClass(connectionLock);
+	return bytesSent;
+}
+
+uint64_t Connection::getMessagesSent()
+{
+	std::lock_guard<std::recursive_mutex> lockClass(connectionLock);
+	return messagesSent;
+}
+
+uint64_t Connection::getWriteOperations()
+{
+	std::lock_guard<std::recursive_mutex> lockClass(connectionLock);
+	return writeOperations;
+}
+
 void Connection::onWriteOperation(const boost::system::error_code& error)
 {
 	std::lock_guard<std::recursive_mutex> lockClass(connectionLock);
 	writeTimer.cancel();
-	messageQueue.pop_front();
+	writingMessages.clear();
 
 	if (error) {
 		messageQueue.clear();
@@ -294,7 +355,7 @@ void Connection::onWriteOperation(const boost::system::error_code& error)
 	}
 
 	if (!messageQueue.empty()) {
-		internalSend(messageQueue.front());
+		internalSend();
 	} else if (connectionState == CONNECTION_STATE_CLOSED) {
 		closeSocket();
 	}
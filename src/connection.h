@@ -20,12 +20,16 @@
 #ifndef FS_CONNECTION_H_FC8E1B4392D24D27A2F129D8B93A6348
 #define FS_CONNECTION_H_FC8E1B4392D24D27A2F129D8B93A6348
 
+#include <atomic>
 #include <unordered_set>
 
+#include <boost/circular_buffer.hpp>
+
 #include "networkmessage.h"
 
 static constexpr int32_t CONNECTION_WRITE_TIMEOUT = 30;
 static constexpr int32_t CONNECTION_READ_TIMEOUT = 30;
+static constexpr size_t CONNECTION_QUEUE_CAPACITY = 32;
 
 class Protocol;
 using Protocol_ptr = std::shared_ptr<Protocol>;
@@ -40,6 +44,12 @@ class ServicePort;
 using ServicePort_ptr = std::shared_ptr<ServicePort>;
 using ConstServicePort_ptr = std::shared_ptr<const ServicePort>;
 
+struct NetworkThreadStats {
+	std::atomic<uint32_t> connections {0};
+	std::atomic<uint64_t> packetsReceived {0};
+	std::atomic<uint64_t> messagesSent {0};
+};
+
 class ConnectionManager
 {
 	public:
@@ -48,7 +58,7 @@ class ConnectionManager
 			return instance;
 		}
 
-		Connection_ptr createConnection(boost::asio::io_service& io_service, ConstServicePort_ptr servicePort);
+		Connection_ptr createConnection(boost::asio::io_service& io_service, NetworkThreadStats& threadStats, ConstServicePort_ptr servicePort);
 		void releaseConnection(const Connection_ptr& connection);
 		void closeAll();
 
@@ -73,13 +83,16 @@ class Connection : public std::enable_shared_from_this<Connection>
 
 		enum { FORCE_CLOSE = true };
 
-		Connection(boost::asio::io_service& io_service,
+		Connection(boost::asio::io_service& io_service, NetworkThreadStats& threadStats,
 		           ConstServicePort_ptr service_port) :
 			readTimer(io_service),
 			writeTimer(io_service),
+			threadStats(threadStats),
 			service_port(std::move(service_port)),
 			socket(io_service),
-			timeConnected(time(nullptr)) {}
+			timeConnected(time(nullptr)) {
+			++threadStats.connections;
+		}
 		~Connection();
 
 		friend class ConnectionManager;
@@ -93,16 +106,22 @@ class Connection : public std::enable_shared_from_this<Connection>
 
 		uint32_t getIP();
 
+		uint64_t getBytesSent();
+		uint64_t getMessagesSent();
+		uint64_t getWriteOperations();
+
 	private:
 		void parseHeader(const boost::system::error_code& error);
 		void parsePacket(const boost::system::error_code& error);
+		void parseQueuedFirstMessage();
+		void readNextPacket();
 
 		void onWriteOperation(const boost::system::error_code& error);
 
 		static void handleTimeout(ConnectionWeak_ptr connectionWeak, const boost::system::error_code& error);
 
 		void closeSocket();
-		void internalSend(const OutputMessage_ptr& msg);
+		void internalSend();
 
 		boost::asio::ip::tcp::socket& getSocket() {
 			return socket;
@@ -114,9 +133,18 @@ class Connection : public std::enable_shared_from_this<Connection>
 		boost::asio::deadline_timer readTimer;
 		boost::asio::deadline_timer writeTimer;
 
+		NetworkThreadStats& threadStats;
+
 		std::recursive_mutex connectionLock;
 
-		std::list<OutputMessage_ptr> messageQueue;
+		// messages waiting for the next write, and the ones the pending write is sending
+		boost::circular_buffer<OutputMessage_ptr> messageQueue {CONNECTION_QUEUE_CAPACITY};
+		std::vector<OutputMessage_ptr> writingMessages;
+		std::vector<boost::asio::const_buffer> writeBuffers;
+
+		uint64_t bytesSent = 0;
+		uint64_t messagesSent = 0;
+		uint64_t writeOperations = 0;
 
 		ConstServicePort_ptr service_port;
 		Protocol_ptr protocol;
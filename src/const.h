@@ -22,6 +22,14 @@
 
 static constexpr int32_t NETWORKMESSAGE_MAXSIZE = 24590;
 
+// how long buffered output of a connection may wait to be sent together
+enum OutputLatency_t : uint8_t {
+	OUTPUT_LATENCY_LOW, // players in fight
+	OUTPUT_LATENCY_NORMAL,
+
+	OUTPUT_LATENCY_LAST = OUTPUT_LATENCY_NORMAL
+};
+
 enum MagicEffectClasses : uint8_t {
 	CONST_ME_NONE,
 
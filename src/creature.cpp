@@ -94,7 +94,7 @@ void Creature::setSkull(Skulls_t newSkull)
 int64_t Creature::getTimeSinceLastMove() const
 {
 	if (lastStep) {
-		return OTSYS_TIME() - lastStep;
+		return OTSYS_CACHED_TIME() - lastStep;
 	}
 	return std::numeric_limits<int64_t>::max();
 }
@@ -105,7 +105,7 @@ int32_t Creature::getWalkDelay(Direction dir) const
 		return 0;
 	}
 
-	int64_t ct = OTSYS_TIME();
+	int64_t ct = OTSYS_CACHED_TIME();
 	int64_t stepDuration = getStepDuration(dir);
 	return stepDuration - (ct - lastStep);
 }
@@ -117,7 +117,7 @@ int32_t Creature::getWalkDelay() const
 		return 0;
 	}
 
-	int64_t ct = OTSYS_TIME();
+	int64_t ct = OTSYS_CACHED_TIME();
 	int64_t stepDuration = getStepDuration() * lastStepCost;
 	return stepDuration - (ct - lastStep);
 }
@@ -301,7 +301,7 @@ void Creature::updateMapCache()
 		for (int32_t x = -maxWalkCacheWidth; x <= maxWalkCacheWidth; ++x) {
 			pos.x = myPos.getX() + x;
 			pos.y = myPos.getY() + y;
-			tile = g_game.map.getTile(pos);
+			tile = g_game.map.getPathTile(pos.x, pos.y, pos.z);
 			updateTileCache(tile, pos);
 		}
 	}
@@ -452,7 +452,7 @@ void Creature::onCreatureMove(Creature* creature, const Tile* newTile, const Pos
                               const Tile* oldTile, const Position& oldPos, bool teleport)
 {
 	if (creature == this) {
-		lastStep = OTSYS_TIME();
+		lastStep = OTSYS_CACHED_TIME();
 		lastStepCost = 1;
 
 		if (!teleport) {
@@ -501,7 +501,7 @@ void Creature::onCreatureMove(Creature* creature, const Tile* newTile, const Pos
 
 					//update 0
 					for (int32_t x = -maxWalkCacheWidth; x <= maxWalkCacheWidth; ++x) {
-						Tile* cacheTile = g_game.map.getTile(myPos.getX() + x, myPos.getY() - maxWalkCacheHeight, myPos.z);
+						Tile* cacheTile = g_game.map.getPathTile(myPos.getX() + x, myPos.getY() - maxWalkCacheHeight, myPos.z);
 						updateTileCache(cacheTile, x, -maxWalkCacheHeight);
 					}
 				} else if (oldPos.y < newPos.y) { // south
@@ -512,7 +512,7 @@ void Creature::onCreatureMove(Creature* creature, const Tile* newTile, const Pos
 
 					//update mapWalkHeight - 1
 					for (int32_t x = -maxWalkCacheWidth; x <= maxWalkCacheWidth; ++x) {
-						Tile* cacheTile = g_game.map.getTile(myPos.getX() + x, myPos.getY() + maxWalkCacheHeight, myPos.z);
+						Tile* cacheTile = g_game.map.getPathTile(myPos.getX() + x, myPos.getY() + maxWalkCacheHeight, myPos.z);
 						updateTileCache(cacheTile, x, maxWalkCacheHeight);
 					}
 				}
@@ -537,7 +537,7 @@ void Creature::onCreatureMove(Creature* creature, const Tile* newTile, const Pos
 
 					//update mapWalkWidth - 1
 					for (int32_t y = -maxWalkCacheHeight; y <= maxWalkCacheHeight; ++y) {
-						Tile* cacheTile = g_game.map.getTile(myPos.x + maxWalkCacheWidth, myPos.y + y, myPos.z);
+						Tile* cacheTile = g_game.map.getPathTile(myPos.x + maxWalkCacheWidth, myPos.y + y, myPos.z);
 						updateTileCache(cacheTile, maxWalkCacheWidth, y);
 					}
 				} else if (oldPos.x > newPos.x) { // west
@@ -560,7 +560,7 @@ void Creature::onCreatureMove(Creature* creature, const Tile* newTile, const Pos
 
 					//update 0
 					for (int32_t y = -maxWalkCacheHeight; y <= maxWalkCacheHeight; ++y) {
-						Tile* cacheTile = g_game.map.getTile(myPos.x - maxWalkCacheWidth, myPos.y + y, myPos.z);
+						Tile* cacheTile = g_game.map.getPathTile(myPos.x - maxWalkCacheWidth, myPos.y + y, myPos.z);
 						updateTileCache(cacheTile, -maxWalkCacheWidth, y);
 					}
 				}
@@ -623,7 +623,7 @@ void Creature::onDeath()
 
 	Creature* mostDamageCreature = nullptr;
 
-	const int64_t timeNow = OTSYS_TIME();
+	const int64_t timeNow = OTSYS_CACHED_TIME();
 	const uint32_t inFightTicks = g_config.getNumber(ConfigManager::PZ_LOCKED);
 	int32_t mostDamage = 0;
 	std::map<Creature*, uint64_t> experienceMap;
@@ -741,7 +741,7 @@ bool Creature::hasBeenAttacked(uint32_t attackerId)
 	if (it == damageMap.end()) {
 		return false;
 	}
-	return (OTSYS_TIME() - it->second.ticks) <= g_config.getNumber(ConfigManager::PZ_LOCKED);
+	return (OTSYS_CACHED_TIME() - it->second.ticks) <= g_config.getNumber(ConfigManager::PZ_LOCKED);
 }
 
 Item* Creature::getCorpse(Creature*, Creature*)
@@ -882,7 +882,7 @@ void Creature::goToFollowCreature()
 				if (!monster->getDistanceStep(followCreature->getPosition(), dir)) {
 					// if we can't get anything then let the A* calculate
 					listWalkDir.clear();
-					if (getPathTo(followCreature->getPosition(), listWalkDir, fpp)) {
+					if (g_game.map.getFollowPath(*this, followCreature->getPosition(), listWalkDir, fpp)) {
 						hasFollowPath = true;
 						startAutoWalk(listWalkDir);
 					} else {
@@ -901,7 +901,7 @@ void Creature::goToFollowCreature()
 			}
 		} else {
 			listWalkDir.clear();
-			if (getPathTo(followCreature->getPosition(), listWalkDir, fpp)) {
+			if (g_game.map.getFollowPath(*this, followCreature->getPosition(), listWalkDir, fpp)) {
 				hasFollowPath = true;
 				startAutoWalk(listWalkDir);
 			} else {
@@ -980,12 +980,12 @@ void Creature::addDamagePoints(Creature* attacker, int32_t damagePoints)
 	auto it = damageMap.find(attackerId);
 	if (it == damageMap.end()) {
 		CountBlock_t cb;
-		cb.ticks = OTSYS_TIME();
+		cb.ticks = OTSYS_CACHED_TIME();
 		cb.total = damagePoints;
 		damageMap[attackerId] = cb;
 	} else {
 		it->second.total += damagePoints;
-		it->second.ticks = OTSYS_TIME();
+		it->second.ticks = OTSYS_CACHED_TIME();
 	}
 
 	lastHitCreatureId = attackerId;
@@ -1085,7 +1085,7 @@ void Creature::onGainExperience(uint64_t gainExp, Creature* target)
 	gainExp /= 2;
 	master->onGainExperience(gainExp, target);
 
-	SpectatorHashSet spectators;
+	SpectatorVec spectators;
 	g_game.map.getSpectators(spectators, position, false, true);
 	if (spectators.empty()) {
 		return;
@@ -1305,7 +1305,7 @@ bool Creature::hasCondition(ConditionType_t type, uint32_t subId/* = 0*/) const
 		return false;
 	}
 
-	int64_t timeNow = OTSYS_TIME();
+	int64_t timeNow = OTSYS_CACHED_TIME();
 	for (Condition* condition : conditions) {
 		if (condition->getType() != type || condition->getSubId() != subId) {
 			continue;
@@ -50,18 +50,57 @@ static Node& getCurrentNode(const NodeStack& nodeStack) {
 	return *nodeStack.top();
 }
 
-const Node& Loader::parseTree()
+// Skips the children of the node whose properties start at it, up to and including its END
+// byte. Sets the end of its properties on the way, as parseNodes does for the other nodes.
+static ContentIt skipChildren(ContentIt it, ContentIt end, Node& node)
 {
-	auto it = fileContents.begin() + sizeof(Identifier);
-	if (static_cast<uint8_t>(*it) != Node::START) {
-		throw InvalidOTBFormat{};
+	size_t depth = 0;
+	bool hasChildren = false;
+	for (; it != end; ++it) {
+		switch (static_cast<uint8_t>(*it)) {
+			case Node::START: {
+				if (!hasChildren) {
+					node.propsEnd = it;
+					hasChildren = true;
+				}
+				++depth;
+				if (++it == end) {
+					throw InvalidOTBFormat{};
+				}
+				break;
+			}
+			case Node::END: {
+				if (depth == 0) {
+					if (!hasChildren) {
+						node.propsEnd = it;
+					}
+					return it;
+				}
+				--depth;
+				break;
+			}
+			case Node::ESCAPE: {
+				if (++it == end) {
+					throw InvalidOTBFormat{};
+				}
+				break;
+			}
+			default: {
+				break;
+			}
+		}
 	}
-	root.type = *(++it);
-	root.propsBegin = ++it;
+	throw InvalidOTBFormat{};
+}
+
+// Builds the tree below root, whose properties start at it, until its END byte.
+static void parseNodes(ContentIt it, ContentIt end, Node& root, int deferredType)
+{
+	root.propsBegin = it;
 	NodeStack parseStack;
 	parseStack.push(&root);
 
-	for (; it != fileContents.end(); ++it) {
+	for (; it != end; ++it) {
 		switch(static_cast<uint8_t>(*it)) {
 			case Node::START: {
 				auto& currentNode = getCurrentNode(parseStack);
@@ -70,12 +109,16 @@ const Node& Loader::parseTree()
 				}
 				currentNode.children.emplace_back();
 				auto& child = currentNode.children.back();
-				if (++it == fileContents.end()) {
+				if (++it == end) {
 					throw InvalidOTBFormat{};
 				}
 				child.type = *it;
 				child.propsBegin = it + sizeof(Node::type);
-				parseStack.push(&child);
+				if (child.type == deferredType) {
+					it = skipChildren(child.propsBegin, end, child);
+				} else {
+					parseStack.push(&child);
+				}
 				break;
 			}
 			case Node::END: {
@@ -84,10 +127,13 @@ const Node& Loader::parseTree()
 					currentNode.propsEnd = it;
 				}
 				parseStack.pop();
+				if (parseStack.empty()) {
+					return;
+				}
 				break;
 			}
 			case Node::ESCAPE: {
-				if (++it == fileContents.end()) {
+				if (++it == end) {
 					throw InvalidOTBFormat{};
 				}
 				break;
@@ -97,27 +143,64 @@ const Node& Loader::parseTree()
 			}
 		}
 	}
-	if (!parseStack.empty()) {
+	throw InvalidOTBFormat{};
+}
+
+static void parseRoot(const MappedFile& fileContents, Node& root, int deferredType)
+{
+	auto it = fileContents.begin() + sizeof(Identifier);
+	if (static_cast<uint8_t>(*it) != Node::START) {
 		throw InvalidOTBFormat{};
 	}
+	root.type = *(++it);
+	parseNodes(++it, fileContents.end(), root, deferredType);
+}
 
+const Node& Loader::parseTree()
+{
+	parseRoot(fileContents, root, -1);
 	return root;
 }
 
+const Node& Loader::parseTree(uint8_t deferredType)
+{
+	parseRoot(fileContents, root, deferredType);
+	return root;
+}
+
+Node Loader::parseSubtree(const Node& node) const
+{
+	Node subtree;
+	subtree.type = node.type;
+	parseNodes(node.propsBegin, fileContents.end(), subtree, -1);
+	return subtree;
+}
+
 bool Loader::getProps(const Node& node, PropStream& props)
+{
+	propBuffer.clear();
+	if (!appendProps(node, propBuffer)) {
+		return false;
+	}
+	props.init(propBuffer.data(), propBuffer.size());
+	return true;
+}
+
+bool Loader::appendProps(const Node& node, std::vector<char>& buffer) const
 {
 	auto size = std::distance(node.propsBegin, node.propsEnd);
 	if (size == 0) {
 		return false;
 	}
-	propBuffer.resize(size);
+	auto offset = buffer.size();
+	buffer.resize(offset + size);
 	bool lastEscaped = false;
 
-	auto escapedPropEnd = std::copy_if(node.propsBegin, node.propsEnd, propBuffer.begin(), [&lastEscaped](const char& byte) {
+	auto escapedPropEnd = std::copy_if(node.propsBegin, node.propsEnd, buffer.begin() + offset, [&lastEscaped](const char& byte) {
 		lastEscaped = byte == static_cast<char>(Node::ESCAPE) && !lastEscaped;
 		return !lastEscaped;
 	});
-	props.init(&propBuffer[0], std::distance(propBuffer.begin(), escapedPropEnd));
+	buffer.erase(escapedPropEnd, buffer.end());
 	return true;
 }
 
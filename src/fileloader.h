@@ -64,7 +64,14 @@ class Loader {
 public:
 	Loader(const std::string& fileName, const Identifier& acceptedIdentifier);
 	bool getProps(const Node& node, PropStream& props);
+	// Appends the unescaped properties of node to buffer. Unlike getProps it keeps no state
+	// in the loader, so several threads may read one file at once.
+	bool appendProps(const Node& node, std::vector<char>& buffer) const;
 	const Node& parseTree();
+	// Like parseTree, but the children of nodes of deferredType are left out of the tree, so
+	// that large files can be processed one such subtree at a time with parseSubtree.
+	const Node& parseTree(uint8_t deferredType);
+	Node parseSubtree(const Node& node) const;
 };
 
 } //namespace OTB
@@ -73,6 +73,16 @@ enum LightState_t {
 static constexpr int32_t EVENT_LIGHTINTERVAL = 10000;
 static constexpr int32_t EVENT_DECAYINTERVAL = 250;
 static constexpr int32_t EVENT_DECAY_BUCKETS = 4;
+static constexpr size_t EVENT_CREATURE_REBALANCE_THRESHOLD = 16;
+
+struct CreatureCheckStats {
+	size_t creatures = 0;
+	uint64_t runs = 0;
+	// durations in microseconds
+	int64_t lastDuration = 0;
+	int64_t maxDuration = 0;
+	int64_t totalDuration = 0;
+};
 
 /**
   * Main Game class.
@@ -307,7 +317,7 @@ class Game
 		  * \param text The text to say
 		  */
 		bool internalCreatureSay(Creature* creature, SpeakClasses type, const std::string& text,
-		                         bool ghostMode, SpectatorHashSet* spectatorsPtr = nullptr, const Position* pos = nullptr);
+		                         bool ghostMode, SpectatorVec* spectatorsPtr = nullptr, const Position* pos = nullptr);
 
 		void loadPlayersRecord();
 		void checkPlayersRecord();
@@ -436,6 +446,10 @@ class Game
 		void checkCreatures(size_t index);
 		void checkLight();
 
+		const CreatureCheckStats& getCreatureCheckStats(size_t index) const {
+			return checkCreatureStats[index];
+		}
+
 		bool combatBlockHit(CombatDamage& damage, Creature* attacker, Creature* target, bool checkDefense, bool checkArmor, bool field);
 
 		void combatGetTypeInfo(CombatType_t combatType, Creature* target, TextColor_t& color, uint8_t& effect);
@@ -445,11 +459,11 @@ class Game
 
 		//animation help functions
 		void addCreatureHealth(const Creature* target);
-		static void addCreatureHealth(const SpectatorHashSet& spectators, const Creature* target);
+		static void addCreatureHealth(const SpectatorVec& spectators, const Creature* target);
 		void addMagicEffect(const Position& pos, uint8_t effect);
-		static void addMagicEffect(const SpectatorHashSet& spectators, const Position& pos, uint8_t effect);
+		static void addMagicEffect(const SpectatorVec& spectators, const Position& pos, uint8_t effect);
 		void addDistanceEffect(const Position& fromPos, const Position& toPos, uint8_t effect);
-		static void addDistanceEffect(const SpectatorHashSet& spectators, const Position& fromPos, const Position& toPos, uint8_t effect);
+		static void addDistanceEffect(const SpectatorVec& spectators, const Position& fromPos, const Position& toPos, uint8_t effect);
 
 		void startDecay(Item* item);
 		int32_t getLightHour() const {
@@ -516,6 +530,9 @@ class Game
 		void checkDecay();
 		void internalDecayItem(Item* item);
 
+		size_t getLeastLoadedCheckBucket() const;
+		void rebalanceCreatureChecks(size_t index);
+
 		std::unordered_map<uint32_t, Player*> players;
 		std::unordered_map<std::string, Player*> mappedPlayerNames;
 		std::unordered_map<uint32_t, Guild*> guilds;
@@ -523,7 +540,8 @@ class Game
 		std::map<uint32_t, uint32_t> stages;
 
 		std::list<Item*> decayItems[EVENT_DECAY_BUCKETS];
-		std::list<Creature*> checkCreatureLists[EVENT_CREATURECOUNT];
+		std::vector<Creature*> checkCreatureLists[EVENT_CREATURECOUNT];
+		CreatureCheckStats checkCreatureStats[EVENT_CREATURECOUNT];
 
 		std::vector<Creature*> ToReleaseCreatures;
 		std::vector<Item*> ToReleaseItems;
@@ -43,6 +43,10 @@ class HouseTile final : public DynamicTile
 			return house;
 		}
 
+		size_t getMemoryUsage() const override {
+			return sizeof(HouseTile) + getListMemoryUsage();
+		}
+
 	private:
 		void updateHouse(Item* item);
 
@@ -22,6 +22,10 @@
 #include "iomap.h"
 
 #include "bed.h"
+#include "jobpool.h"
+
+#include <fstream>
+#include <boost/filesystem.hpp>
 
 /*
 	OTBM_ROOTV1
@@ -47,6 +51,314 @@
 	|--- OTBM_ITEM_DEF (not implemented)
 */
 
+// a single tile area decodes in about a microsecond, jobs take several to pay for themselves
+static constexpr size_t TILE_AREAS_PER_JOB = 64;
+
+// A tile area decoded off the dispatcher thread. Items are only created when the area
+// is loaded into the map, since reading their attributes may touch game state.
+struct IOMap::TileArea
+{
+	struct TileData {
+		uint32_t houseId;
+		uint32_t flags;
+		uint32_t firstItem;
+		uint32_t itemCount;
+		uint16_t x;
+		uint16_t y;
+		bool isHouseTile;
+	};
+
+	struct ItemData {
+		// nullptr for items stored as tile attributes
+		const OTB::Node* node;
+		size_t propsBegin;
+		size_t propsEnd;
+	};
+
+	// the node in the file, kept to load the area again later
+	const OTB::Node* source = nullptr;
+	OTB::Node node;
+	std::vector<TileData> tiles;
+	std::vector<ItemData> items;
+	std::vector<char> props;
+	// set when decoding stopped early, reported after the tiles decoded before it are loaded
+	std::string error;
+	uint16_t z = 0;
+};
+
+// Decoded tile areas saved next to the map file, so that later startups read them instead of
+// decoding the map again. The cache belongs to the exact map file it was written from, which
+// is told by its size, modification time and a hash of its contents. It is only read back by
+// the server that wrote it, so everything is stored in host byte order.
+struct IOMap::TileAreaCache
+{
+	static constexpr uint32_t VERSION = 1;
+
+	struct Header {
+		OTB::Identifier identifier;
+		uint32_t version;
+		uint64_t mapSize;
+		int64_t mapTime;
+		uint64_t mapHash;
+		uint32_t areaCount;
+		uint32_t indexOffset;
+	};
+
+	// offset 0 is the header, so an entry with offset 0 marks a tile area that is not cached
+	struct Entry {
+		uint32_t offset;
+		uint32_t nodeIndex;
+		uint32_t tileCount;
+		uint32_t itemCount;
+		uint32_t propsSize;
+		uint32_t z;
+	};
+
+	struct ItemData {
+		uint32_t propsBegin;
+		uint32_t propsEnd;
+		uint32_t hasNode;
+	};
+
+	~TileAreaCache() {
+		if (out.is_open()) {
+			out.close();
+			boost::system::error_code ec;
+			boost::filesystem::remove(tmpName, ec);
+		}
+	}
+
+	static bool stamp(const std::string& mapName, Header& header);
+
+	bool load(const std::string& fileName, const Header& stamp, const OTB::Node::ChildrenVector& mapDataNodes);
+	bool read(size_t nodeIndex, const OTB::Node& tileAreaNode, TileArea& area) const;
+
+	bool create(const std::string& fileName);
+	void write(size_t nodeIndex, const TileArea& area);
+	bool finish(Header header);
+
+	std::string name;
+	std::string tmpName;
+
+	OTB::MappedFile file;
+	std::vector<Entry> entries;
+	size_t cachedAreas = 0;
+
+	std::ofstream out;
+	std::vector<Entry> written;
+	uint64_t writeOffset = 0;
+};
+
+// items read from the cache have no child nodes, areas with container contents are not cached
+static const OTB::Node cachedItemNode{};
+
+bool IOMap::TileAreaCache::stamp(const std::string& mapName, Header& header)
+{
+	boost::system::error_code ec;
+	header.mapSize = boost::filesystem::file_size(mapName, ec);
+	if (ec) {
+		return false;
+	}
+
+	header.mapTime = boost::filesystem::last_write_time(mapName, ec);
+	if (ec) {
+		return false;
+	}
+
+	OTB::MappedFile mapFile;
+	try {
+		mapFile.open(mapName);
+	} catch (const std::exception&) {
+		return false;
+	}
+
+	// FNV-1a over 8 byte words with the high half folded in, the SHA1 from tools.cpp takes
+	// as long as decoding the map
+	const char* data = mapFile.data();
+	size_t size = mapFile.size();
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, data + i, sizeof(word));
+		hash = (hash ^ word) * 0x100000001B3ULL;
+		hash ^= hash >> 32;
+	}
+	for (; i < size; ++i) {
+		hash = (hash ^ static_cast<uint8_t>(data[i])) * 0x100000001B3ULL;
+	}
+
+	header.identifier = {{'O', 'T', 'B', 'C'}};
+	header.version = VERSION;
+	header.mapHash = hash;
+	header.areaCount = 0;
+	header.indexOffset = 0;
+	return true;
+}
+
+bool IOMap::TileAreaCache::load(const std::string& fileName, const Header& stamp, const OTB::Node::ChildrenVector& mapDataNodes)
+{
+	boost::system::error_code ec;
+	if (!boost::filesystem::exists(fileName, ec)) {
+		return false;
+	}
+
+	try {
+		file.open(fileName);
+	} catch (const std::exception&) {
+		return false;
+	}
+
+	Header header;
+	if (file.size() < sizeof(header)) {
+		return false;
+	}
+
+	memcpy(&header, file.data(), sizeof(header));
+	if (header.identifier != stamp.identifier || header.version != stamp.version || header.mapSize != stamp.mapSize ||
+	        header.mapTime != stamp.mapTime || header.mapHash != stamp.mapHash) {
+		return false;
+	}
+
+	if (header.indexOffset < sizeof(header) || header.indexOffset + static_cast<uint64_t>(header.areaCount) * sizeof(Entry) > file.size()) {
+		return false;
+	}
+
+	entries.assign(mapDataNodes.size(), Entry());
+	for (uint32_t i = 0; i < header.areaCount; ++i) {
+		Entry entry;
+		memcpy(&entry, file.data() + header.indexOffset + i * sizeof(Entry), sizeof(entry));
+
+		uint64_t size = static_cast<uint64_t>(entry.tileCount) * sizeof(TileArea::TileData) + static_cast<uint64_t>(entry.itemCount) * sizeof(ItemData) + entry.propsSize;
+		if (entry.offset < sizeof(header) || entry.offset + size > header.indexOffset ||
+		        entry.nodeIndex >= mapDataNodes.size() || mapDataNodes[entry.nodeIndex].type != OTBM_TILE_AREA) {
+			entries.clear();
+			return false;
+		}
+
+		entries[entry.nodeIndex] = entry;
+	}
+
+	cachedAreas = header.areaCount;
+	return true;
+}
+
+bool IOMap::TileAreaCache::read(size_t nodeIndex, const OTB::Node& tileAreaNode, TileArea& area) const
+{
+	if (nodeIndex >= entries.size() || entries[nodeIndex].offset == 0) {
+		return false;
+	}
+
+	const Entry& entry = entries[nodeIndex];
+	const char* data = file.data() + entry.offset;
+
+	area.source = &tileAreaNode;
+	area.z = entry.z;
+
+	area.tiles.resize(entry.tileCount);
+	memcpy(area.tiles.data(), data, entry.tileCount * sizeof(TileArea::TileData));
+	data += entry.tileCount * sizeof(TileArea::TileData);
+
+	area.items.resize(entry.itemCount);
+	for (auto& item : area.items) {
+		ItemData itemData;
+		memcpy(&itemData, data, sizeof(itemData));
+		data += sizeof(itemData);
+
+		if (itemData.propsBegin > itemData.propsEnd || itemData.propsEnd > entry.propsSize) {
+			return false;
+		}
+
+		item.node = itemData.hasNode != 0 ? &cachedItemNode : nullptr;
+		item.propsBegin = itemData.propsBegin;
+		item.propsEnd = itemData.propsEnd;
+	}
+
+	for (auto& tile : area.tiles) {
+		if (tile.firstItem > entry.itemCount || tile.itemCount > entry.itemCount - tile.firstItem) {
+			return false;
+		}
+	}
+
+	area.props.assign(data, data + entry.propsSize);
+	return true;
+}
+
+bool IOMap::TileAreaCache::create(const std::string& fileName)
+{
+	name = fileName;
+	tmpName = fileName + ".tmp";
+	out.open(tmpName, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		return false;
+	}
+
+	// the header is written last, once the index offset is known
+	Header header = {};
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	writeOffset = sizeof(header);
+	return true;
+}
+
+void IOMap::TileAreaCache::write(size_t nodeIndex, const TileArea& area)
+{
+	for (auto& item : area.items) {
+		if (item.node && !item.node->children.empty()) {
+			return;
+		}
+	}
+
+	Entry entry;
+	entry.offset = static_cast<uint32_t>(writeOffset);
+	entry.nodeIndex = static_cast<uint32_t>(nodeIndex);
+	entry.tileCount = static_cast<uint32_t>(area.tiles.size());
+	entry.itemCount = static_cast<uint32_t>(area.items.size());
+	entry.propsSize = static_cast<uint32_t>(area.props.size());
+	entry.z = area.z;
+
+	out.write(reinterpret_cast<const char*>(area.tiles.data()), area.tiles.size() * sizeof(TileArea::TileData));
+	for (auto& item : area.items) {
+		ItemData itemData;
+		itemData.propsBegin = static_cast<uint32_t>(item.propsBegin);
+		itemData.propsEnd = static_cast<uint32_t>(item.propsEnd);
+		itemData.hasNode = item.node ? 1 : 0;
+		out.write(reinterpret_cast<const char*>(&itemData), sizeof(itemData));
+	}
+	out.write(area.props.data(), area.props.size());
+
+	writeOffset += area.tiles.size() * sizeof(TileArea::TileData) + area.items.size() * sizeof(ItemData) + area.props.size();
+	written.push_back(entry);
+}
+
+bool IOMap::TileAreaCache::finish(Header header)
+{
+	// offsets are stored in 32 bits, a map this large is simply not cached
+	if (writeOffset + written.size() * sizeof(Entry) > std::numeric_limits<uint32_t>::max()) {
+		return false;
+	}
+
+	header.areaCount = static_cast<uint32_t>(written.size());
+	header.indexOffset = static_cast<uint32_t>(writeOffset);
+
+	out.write(reinterpret_cast<const char*>(written.data()), written.size() * sizeof(Entry));
+	out.seekp(0);
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.close();
+	if (!out) {
+		boost::system::error_code ec;
+		boost::filesystem::remove(tmpName, ec);
+		return false;
+	}
+
+	boost::system::error_code ec;
+	boost::filesystem::rename(tmpName, name, ec);
+	if (ec) {
+		boost::filesystem::remove(tmpName, ec);
+		return false;
+	}
+	return true;
+}
+
 Tile* IOMap::createTile(Item*& ground, Item* item, uint16_t x, uint16_t y, uint8_t z)
 {
 	if (!ground) {
@@ -66,11 +378,14 @@ Tile* IOMap::createTile(Item*& ground, Item* item, uint16_t x, uint16_t y, uint8
 	return tile;
 }
 
-bool IOMap::loadMap(Map* map, const std::string& fileName)
+bool IOMap::loadMap(Map* map, const std::string& fileName, bool lazy)
 {
 	int64_t start = OTSYS_TIME();
-	OTB::Loader loader{fileName, OTB::Identifier{{'O', 'T', 'B', 'M'}}};
-	auto& root = loader.parseTree();
+	// a lazily loaded map keeps the file open, see Map::loadRegion
+	std::unique_ptr<OTB::Loader> fileLoader(new OTB::Loader(fileName, OTB::Identifier{{'O', 'T', 'B', 'M'}}));
+	OTB::Loader& loader = *fileLoader;
+	// tile areas make up nearly all of the file, they are parsed one at a time below
+	auto& root = loader.parseTree(OTBM_TILE_AREA);
 
 	PropStream propStream;
 	if (!loader.getProps(root, propStream)) {
@@ -120,6 +435,7 @@ bool IOMap::loadMap(Map* map, const std::string& fileName)
 	std::cout << "> Map size: " << root_header.width << "x" << root_header.height << '.' << std::endl;
 	map->width = root_header.width;
 	map->height = root_header.height;
+	map->createLeafIndex(root_header.width, root_header.height);
 
 	if (root.children.size() != 1 || root.children[0].type != OTBM_MAP_DATA) {
 		setLastErrorString("Could not read data node.");
@@ -131,12 +447,107 @@ bool IOMap::loadMap(Map* map, const std::string& fileName)
 		return false;
 	}
 
-	for (auto& mapDataNode : mapNode.children) {
+	auto& mapDataNodes = mapNode.children;
+
+	// a lazily loaded map builds most areas later on, so there is nothing to save
+	TileAreaCache cache;
+	TileAreaCache::Header cacheStamp;
+	bool writeCache = false;
+	if (!lazy && g_config.getBoolean(ConfigManager::MAP_CACHE) && TileAreaCache::stamp(fileName, cacheStamp)) {
+		if (cache.load(fileName + ".cache", cacheStamp, mapDataNodes)) {
+			std::cout << "> Map tile areas read from cache: " << cache.cachedAreas << '.' << std::endl;
+		} else {
+			writeCache = cache.create(fileName + ".cache");
+		}
+	}
+
+	// tile areas are decoded on the job pool in batches and loaded into the map in file order,
+	// jobs still in flight read the mapped files so they are waited for on every way out
+	struct PendingTileAreas : std::deque<std::future<std::vector<TileArea>>> {
+		~PendingTileAreas() {
+			for (auto& future : *this) {
+				if (future.valid()) {
+					future.wait();
+				}
+			}
+		}
+	} pendingAreas;
+
+	// Areas with house tiles are always built, houses must know all their tiles once the house
+	// file is read. So are areas that failed to decode, to report the error now.
+	auto loadTileAreas = [&](const std::vector<TileArea>& areas) {
+		for (auto& area : areas) {
+			if (lazy && area.error.empty() && std::none_of(area.tiles.begin(), area.tiles.end(), [](const TileArea::TileData& tile) { return tile.isHouseTile; })) {
+				for (auto& tile : area.tiles) {
+					map->addPendingArea(tile.x, tile.y, area.z, *area.source);
+				}
+				continue;
+			}
+
+			if (!loadTileArea(loader, area, *map)) {
+				return false;
+			}
+
+			if (writeCache) {
+				cache.write(area.source - mapDataNodes.data(), area);
+			}
+		}
+		return true;
+	};
+
+	const size_t maxPendingBatches = g_jobPool.getThreadCount() * 4;
+	auto loadPendingAreas = [&](size_t maxPending) {
+		while (pendingAreas.size() > maxPending) {
+			std::vector<TileArea> areas = pendingAreas.front().get();
+			pendingAreas.pop_front();
+			if (!loadTileAreas(areas)) {
+				return false;
+			}
+		}
+		return true;
+	};
+
+	for (size_t i = 0, size = mapDataNodes.size(); i < size; ++i) {
+		auto& mapDataNode = mapDataNodes[i];
 		if (mapDataNode.type == OTBM_TILE_AREA) {
-			if (!parseTileArea(loader, mapDataNode, *map)) {
+			size_t last = i + 1;
+			while (last < size && last - i < TILE_AREAS_PER_JOB && mapDataNodes[last].type == OTBM_TILE_AREA) {
+				++last;
+			}
+
+			auto decodeBatch = [&loader, &cache, &mapDataNodes, i, last]() {
+				std::vector<TileArea> areas;
+				areas.reserve(last - i);
+				for (size_t j = i; j < last; ++j) {
+					areas.emplace_back();
+					if (!cache.read(j, mapDataNodes[j], areas.back())) {
+						areas.back() = decodeTileArea(loader, mapDataNodes[j]);
+					}
+				}
+				return areas;
+			};
+			i = last - 1;
+
+			if (maxPendingBatches == 0) {
+				if (!loadTileAreas(decodeBatch())) {
+					return false;
+				}
+				continue;
+			}
+
+			pendingAreas.push_back(g_jobPool.addJob(decodeBatch));
+			if (!loadPendingAreas(maxPendingBatches)) {
 				return false;
 			}
-		} else if (mapDataNode.type == OTBM_TOWNS) {
+			continue;
+		}
+
+		// towns and waypoints are read once every tile area before them is in the map
+		if (!loadPendingAreas(0)) {
+			return false;
+		}
+
+		if (mapDataNode.type == OTBM_TOWNS) {
 			if (!parseTowns(loader, mapDataNode, *map)) {
 				return false;
 			}
@@ -150,7 +561,26 @@ bool IOMap::loadMap(Map* map, const std::string& fileName)
 		}
 	}
 
+	if (!loadPendingAreas(0)) {
+		return false;
+	}
+
+	if (writeCache && cache.finish(cacheStamp)) {
+		std::cout << "> Map tile areas saved to cache: " << cache.written.size() << '.' << std::endl;
+	}
+
 	std::cout << "> Map loading time: " << (OTSYS_TIME() - start) / (1000.) << " seconds." << std::endl;
+
+	size_t tileCount, tileBytes;
+	map->getTileMemoryUsage(tileCount, tileBytes);
+	if (tileCount != 0) {
+		std::cout << "> Map tiles: " << tileCount << ", " << tileBytes / tileCount << " bytes per tile." << std::endl;
+	}
+
+	if (map->getPendingRegionCount() != 0) {
+		map->regionLoader = std::move(fileLoader);
+	}
+
 	return true;
 }
 
@@ -203,72 +633,72 @@ bool IOMap::parseMapDataAttributes(OTB::Loader& loader, const OTB::Node& mapNode
 	return true;
 }
 
-bool IOMap::parseTileArea(OTB::Loader& loader, const OTB::Node& tileAreaNode, Map& map)
+IOMap::TileArea IOMap::decodeTileArea(const OTB::Loader& loader, const OTB::Node& tileAreaNode)
 {
+	TileArea area;
+	area.source = &tileAreaNode;
+	area.node = loader.parseSubtree(tileAreaNode);
+
+	std::vector<char> buffer;
 	PropStream propStream;
-	if (!loader.getProps(tileAreaNode, propStream)) {
-		setLastErrorString("Invalid map node.");
-		return false;
+	if (!loader.appendProps(area.node, buffer)) {
+		area.error = "Invalid map node.";
+		return area;
 	}
+	propStream.init(buffer.data(), buffer.size());
 
 	OTBM_Destination_coords area_coord;
 	if (!propStream.read(area_coord)) {
-		setLastErrorString("Invalid map node.");
-		return false;
+		area.error = "Invalid map node.";
+		return area;
 	}
 
 	uint16_t base_x = area_coord.x;
 	uint16_t base_y = area_coord.y;
 	uint16_t z = area_coord.z;
+	area.z = z;
 
-	for (auto& tileNode : tileAreaNode.children) {
+	area.tiles.reserve(area.node.children.size());
+	for (auto& tileNode : area.node.children) {
 		if (tileNode.type != OTBM_TILE && tileNode.type != OTBM_HOUSETILE) {
-			setLastErrorString("Unknown tile node.");
-			return false;
+			area.error = "Unknown tile node.";
+			return area;
 		}
 
-		if (!loader.getProps(tileNode, propStream)) {
-			setLastErrorString("Could not read node data.");
-			return false;
+		buffer.clear();
+		if (!loader.appendProps(tileNode, buffer)) {
+			area.error = "Could not read node data.";
+			return area;
 		}
+		propStream.init(buffer.data(), buffer.size());
 
 		OTBM_Tile_coords tile_coord;
 		if (!propStream.read(tile_coord)) {
-			setLastErrorString("Could not read tile position.");
-			return false;
+			area.error = "Could not read tile position.";
+			return area;
 		}
 
-		uint16_t x = base_x + tile_coord.x;
-		uint16_t y = base_y + tile_coord.y;
-
-		bool isHouseTile = false;
-		House* house = nullptr;
-		Tile* tile = nullptr;
-		Item* ground_item = nullptr;
-		uint32_t tileflags = TILESTATE_NONE;
-
-		if (tileNode.type == OTBM_HOUSETILE) {
-			uint32_t houseId;
-			if (!propStream.read<uint32_t>(houseId)) {
-				std::ostringstream ss;
-				ss << "[x:" << x << ", y:" << y << ", z:" << z << "] Could not read house id.";
-				setLastErrorString(ss.str());
-				return false;
-			}
-
-			house = map.houses.addHouse(houseId);
-			if (!house) {
-				std::ostringstream ss;
-				ss << "[x:" << x << ", y:" << y << ", z:" << z << "] Could not create house id: " << houseId;
-				setLastErrorString(ss.str());
-				return false;
-			}
-
-			tile = new HouseTile(x, y, z, house);
-			house->addTile(static_cast<HouseTile*>(tile));
-			isHouseTile = true;
+		TileArea::TileData tile;
+		tile.houseId = 0;
+		tile.flags = TILESTATE_NONE;
+		tile.firstItem = area.items.size();
+		tile.itemCount = 0;
+		tile.x = base_x + tile_coord.x;
+		tile.y = base_y + tile_coord.y;
+		tile.isHouseTile = tileNode.type == OTBM_HOUSETILE;
+
+		uint16_t x = tile.x;
+		uint16_t y = tile.y;
+
+		if (tile.isHouseTile && !propStream.read<uint32_t>(tile.houseId)) {
+			std::ostringstream ss;
+			ss << "[x:" << x << ", y:" << y << ", z:" << z << "] Could not read house id.";
+			area.error = ss.str();
+			return area;
 		}
 
+		// a tile that fails to decode is still loaded up to that point, so that errors
+		// are reported in the same order as when everything was read in one pass
 		uint8_t attribute;
 		//read tile attributes
 		while (propStream.read<uint8_t>(attribute)) {
@@ -278,54 +708,44 @@ bool IOMap::parseTileArea(OTB::Loader& loader, const OTB::Node& tileAreaNode, Ma
 					if (!propStream.read<uint32_t>(flags)) {
 						std::ostringstream ss;
 						ss << "[x:" << x << ", y:" << y << ", z:" << z << "] Failed to read tile flags.";
-						setLastErrorString(ss.str());
-						return false;
+						area.error = ss.str();
+						area.tiles.push_back(tile);
+						return area;
 					}
 
 					if ((flags & OTBM_TILEFLAG_PROTECTIONZONE) != 0) {
-						tileflags |= TILESTATE_PROTECTIONZONE;
+						tile.flags |= TILESTATE_PROTECTIONZONE;
 					} else if ((flags & OTBM_TILEFLAG_NOPVPZONE) != 0) {
-						tileflags |= TILESTATE_NOPVPZONE;
+						tile.flags |= TILESTATE_NOPVPZONE;
 					} else if ((flags & OTBM_TILEFLAG_PVPZONE) != 0) {
-						tileflags |= TILESTATE_PVPZONE;
+						tile.flags |= TILESTATE_PVPZONE;
 					}
 
 					if ((flags & OTBM_TILEFLAG_NOLOGOUT) != 0) {
-						tileflags |= TILESTATE_NOLOGOUT;
+						tile.flags |= TILESTATE_NOLOGOUT;
 					}
 					break;
 				}
 
 				case OTBM_ATTR_ITEM: {
-					Item* item = Item::CreateItem(propStream);
-					if (!item) {
-						std::ostringstream ss;
-						ss << "[x:" << x << ", y:" << y << ", z:" << z << "] Failed to create item.";
-						setLastErrorString(ss.str());
-						return false;
+					TileArea::ItemData item;
+					item.node = nullptr;
+					item.propsBegin = area.props.size();
+
+					uint16_t id;
+					if (propStream.read<uint16_t>(id)) {
+						const char* idBytes = reinterpret_cast<const char*>(&id);
+						area.props.insert(area.props.end(), idBytes, idBytes + sizeof(id));
 					}
 
-					if (isHouseTile && item->isMoveable()) {
-						std::cout << "[Warning - IOMap::loadMap] Moveable item with ID: " << item->getID() << ", in house: " << house->getId() << ", at position [x: " << x << ", y: " << y << ", z: " << z << "]." << std::endl;
-						delete item;
-					} else {
-						if (item->getItemCount() == 0) {
-							item->setItemCount(1);
-						}
-
-						if (tile) {
-							tile->internalAddThing(item);
-							item->startDecaying();
-							item->setLoadedFromMap(true);
-						} else if (item->isGroundTile()) {
-							delete ground_item;
-							ground_item = item;
-						} else {
-							tile = createTile(ground_item, item, x, y, z);
-							tile->internalAddThing(item);
-							item->startDecaying();
-							item->setLoadedFromMap(true);
-						}
+					item.propsEnd = area.props.size();
+					area.items.push_back(item);
+					++tile.itemCount;
+
+					if (item.propsBegin == item.propsEnd) {
+						// loading this item fails, nothing after it is needed
+						area.tiles.push_back(tile);
+						return area;
 					}
 					break;
 				}
@@ -333,8 +753,9 @@ bool IOMap::parseTileArea(OTB::Loader& loader, const OTB::Node& tileAreaNode, Ma
 				default:
 					std::ostringstream ss;
 					ss << "[x:" << x << ", y:" << y << ", z:" << z << "] Unknown tile attribute.";
-					setLastErrorString(ss.str());
-					return false;
+					area.error = ss.str();
+					area.tiles.push_back(tile);
+					return area;
 			}
 		}
 
@@ -342,15 +763,66 @@ bool IOMap::parseTileArea(OTB::Loader& loader, const OTB::Node& tileAreaNode, Ma
 			if (itemNode.type != OTBM_ITEM) {
 				std::ostringstream ss;
 				ss << "[x:" << x << ", y:" << y << ", z:" << z << "] Unknown node type.";
+				area.error = ss.str();
+				area.tiles.push_back(tile);
+				return area;
+			}
+
+			TileArea::ItemData item;
+			item.node = &itemNode;
+			item.propsBegin = area.props.size();
+			if (!loader.appendProps(itemNode, area.props)) {
+				area.error = "Invalid item node.";
+				area.tiles.push_back(tile);
+				return area;
+			}
+
+			item.propsEnd = area.props.size();
+			area.items.push_back(item);
+			++tile.itemCount;
+		}
+
+		area.tiles.push_back(tile);
+	}
+	return area;
+}
+
+bool IOMap::loadTileArea(OTB::Loader& loader, const OTB::Node& tileAreaNode, Map& map)
+{
+	return loadTileArea(loader, decodeTileArea(loader, tileAreaNode), map);
+}
+
+bool IOMap::loadTileArea(OTB::Loader& loader, const TileArea& area, Map& map)
+{
+	uint16_t z = area.z;
+	for (auto& tileData : area.tiles) {
+		uint16_t x = tileData.x;
+		uint16_t y = tileData.y;
+
+		bool isHouseTile = false;
+		House* house = nullptr;
+		Tile* tile = nullptr;
+		Item* ground_item = nullptr;
+
+		if (tileData.isHouseTile) {
+			house = map.houses.addHouse(tileData.houseId);
+			if (!house) {
+				std::ostringstream ss;
+				ss << "[x:" << x << ", y:" << y << ", z:" << z << "] Could not create house id: " << tileData.houseId;
 				setLastErrorString(ss.str());
 				return false;
 			}
 
+			tile = new HouseTile(x, y, z, house);
+			house->addTile(static_cast<HouseTile*>(tile));
+			isHouseTile = true;
+		}
+
+		for (uint32_t i = tileData.firstItem, end = tileData.firstItem + tileData.itemCount; i < end; ++i) {
+			const TileArea::ItemData& itemData = area.items[i];
+
 			PropStream stream;
-			if (!loader.getProps(itemNode, stream)) {
-				setLastErrorString("Invalid item node.");
-				return false;
-			}
+			stream.init(area.props.data() + itemData.propsBegin, itemData.propsEnd - itemData.propsBegin);
 
 			Item* item = Item::CreateItem(stream);
 			if (!item) {
@@ -360,7 +832,7 @@ bool IOMap::parseTileArea(OTB::Loader& loader, const OTB::Node& tileAreaNode, Ma
 				return false;
 			}
 
-			if (!item->unserializeItemNode(loader, itemNode, stream)) {
+			if (itemData.node && !item->unserializeItemNode(loader, *itemData.node, stream)) {
 				std::ostringstream ss;
 				ss << "[x:" << x << ", y:" << y << ", z:" << z << "] Failed to load item " << item->getID() << '.';
 				setLastErrorString(ss.str());
@@ -396,10 +868,15 @@ bool IOMap::parseTileArea(OTB::Loader& loader, const OTB::Node& tileAreaNode, Ma
 			tile = createTile(ground_item, nullptr, x, y, z);
 		}
 
-		tile->setFlag(static_cast<tileflags_t>(tileflags));
+		tile->setFlag(static_cast<tileflags_t>(tileData.flags));
 
 		map.setTile(x, y, z, tile);
 	}
+
+	if (!area.error.empty()) {
+		setLastErrorString(area.error);
+		return false;
+	}
 	return true;
 }
 
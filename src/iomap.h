@@ -104,10 +104,17 @@ struct OTBM_Tile_coords {
 
 class IOMap
 {
+	struct TileArea;
+	struct TileAreaCache;
+
 	static Tile* createTile(Item*& ground, Item* item, uint16_t x, uint16_t y, uint8_t z);
+	static TileArea decodeTileArea(const OTB::Loader& loader, const OTB::Node& tileAreaNode);
 
 	public:
-		bool loadMap(Map* map, const std::string& fileName);
+		// A lazy load builds only the tile areas with house tiles, the others are built by
+		// the map on first use, see Map::loadRegion.
+		bool loadMap(Map* map, const std::string& fileName, bool lazy = false);
+		bool loadTileArea(OTB::Loader& loader, const OTB::Node& tileAreaNode, Map& map);
 
 		/* Load the spawns
 		 * \param map pointer to the Map class
@@ -151,7 +158,7 @@ class IOMap
 		bool parseMapDataAttributes(OTB::Loader& loader, const OTB::Node& mapNode, Map& map, const std::string& fileName);
 		bool parseWaypoints(OTB::Loader& loader, const OTB::Node& waypointsNode, Map& map);
 		bool parseTowns(OTB::Loader& loader, const OTB::Node& townsNode, Map& map);
-		bool parseTileArea(OTB::Loader& loader, const OTB::Node& tileAreaNode, Map& map);
+		bool loadTileArea(OTB::Loader& loader, const TileArea& area, Map& map);
 		std::string errorString;
 };
 
@@ -0,0 +1,133 @@
+/**
+ * The Forgotten Server - a free and open-source MMORPG server emulator
+ * Copyright (C) 2019  Mark Samman <mark.samman@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "otpch.h"
+
+#include "jobpool.h"
+
+// index of the worker running on this thread, jobs queued from a worker stay local
+static thread_local size_t currentWorker = std::numeric_limits<size_t>::max();
+
+void JobPool::start(size_t threadCount)
+{
+	running = true;
+
+	workers.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; ++i) {
+		workers.emplace_back(new Worker);
+	}
+
+	for (size_t i = 0; i < threadCount; ++i) {
+		workers[i]->thread = std::thread(&JobPool::threadMain, this, i);
+	}
+}
+
+void JobPool::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lockClass(signalLock);
+		running = false;
+	}
+	jobSignal.notify_all();
+}
+
+void JobPool::join()
+{
+	for (auto& worker : workers) {
+		if (worker->thread.joinable()) {
+			worker->thread.join();
+		}
+	}
+}
+
+void JobPool::threadMain(size_t index)
+{
+	currentWorker = index;
+
+	Job job;
+	while (true) {
+		if (popJob(index, job)) {
+			--pendingJobs;
+			job();
+			job = nullptr;
+			continue;
+		}
+
+		std::unique_lock<std::mutex> signalLockUnique(signalLock);
+		if (pendingJobs == 0) {
+			if (!running) {
+				// queued jobs are always finished before the workers exit
+				break;
+			}
+			jobSignal.wait(signalLockUnique);
+		}
+	}
+}
+
+void JobPool::pushJob(Job job)
+{
+	if (workers.empty()) {
+		// not started (or started without workers), run it on the calling thread
+		job();
+		return;
+	}
+
+	size_t index = currentWorker;
+	if (index >= workers.size()) {
+		index = nextWorker++ % workers.size();
+	}
+
+	{
+		// counted before it is visible, so a worker can never see more jobs than pendingJobs
+		std::lock_guard<std::mutex> lockClass(signalLock);
+		++pendingJobs;
+	}
+
+	Worker& worker = *workers[index];
+	{
+		std::lock_guard<std::mutex> lockClass(worker.jobLock);
+		worker.jobs.push_back(std::move(job));
+	}
+	jobSignal.notify_one();
+}
+
+bool JobPool::popJob(size_t index, Job& job)
+{
+	{
+		// newest local job first, it is the most likely to still be in cache
+		Worker& worker = *workers[index];
+		std::lock_guard<std::mutex> lockClass(worker.jobLock);
+		if (!worker.jobs.empty()) {
+			job = std::move(worker.jobs.back());
+			worker.jobs.pop_back();
+			return true;
+		}
+	}
+
+	for (size_t i = 1, size = workers.size(); i < size; ++i) {
+		Worker& victim = *workers[(index + i) % size];
+		std::lock_guard<std::mutex> lockClass(victim.jobLock);
+		if (!victim.jobs.empty()) {
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,111 @@
+/**
+ * The Forgotten Server - a free and open-source MMORPG server emulator
+ * Copyright (C) 2019  Mark Samman <mark.samman@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FS_JOBPOOL_H_81416CF674DC4805842AD5BF55748E2C
+#define FS_JOBPOOL_H_81416CF674DC4805842AD5BF55748E2C
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include "tasks.h"
+
+// Runs CPU bound work that does not touch game state on all cores.
+// Every worker owns a queue and idle workers steal from the others.
+class JobPool
+{
+	public:
+		JobPool() = default;
+
+		// non-copyable
+		JobPool(const JobPool&) = delete;
+		JobPool& operator=(const JobPool&) = delete;
+
+		void start(size_t threadCount);
+		void shutdown();
+		void join();
+
+		size_t getThreadCount() const {
+			return workers.size();
+		}
+
+		// The result is available through the returned future.
+		// Never wait for a future from inside a job, the worker would block.
+		template <typename Function>
+		std::future<typename std::result_of<Function()>::type> addJob(Function function) {
+			using Result = typename std::result_of<Function()>::type;
+			auto job = std::make_shared<std::packaged_task<Result()>>(std::move(function));
+			std::future<Result> future = job->get_future();
+			pushJob([job]() { (*job)(); });
+			return future;
+		}
+
+		// The continuation runs on the dispatcher thread and receives the result.
+		template <typename Function, typename Continuation>
+		void addJob(Function function, Continuation continuation) {
+			using Result = typename std::result_of<Function()>::type;
+			pushJob([function, continuation]() mutable {
+				JobContinuation<Result>::run(function, continuation);
+			});
+		}
+
+		void threadMain(size_t index);
+
+	private:
+		using Job = std::function<void (void)>;
+
+		template <typename Result>
+		struct JobContinuation {
+			template <typename Function, typename Continuation>
+			static void run(Function& function, Continuation& continuation) {
+				auto result = std::make_shared<Result>(function());
+				g_dispatcher.addTask(createTask([continuation, result]() mutable { continuation(*result); }));
+			}
+		};
+
+		struct Worker {
+			std::deque<Job> jobs;
+			std::mutex jobLock;
+			std::thread thread;
+		};
+
+		void pushJob(Job job);
+		bool popJob(size_t index, Job& job);
+
+		std::vector<std::unique_ptr<Worker>> workers;
+
+		std::mutex signalLock;
+		std::condition_variable jobSignal;
+
+		std::atomic<size_t> pendingJobs {0};
+		std::atomic<size_t> nextWorker {0};
+		std::atomic<bool> running {false};
+};
+
+template <>
+struct JobPool::JobContinuation<void> {
+	template <typename Function, typename Continuation>
+	static void run(Function& function, Continuation& continuation) {
+		function();
+		g_dispatcher.addTask(createTask(continuation));
+	}
+};
+
+extern JobPool g_jobPool;
+
+#endif
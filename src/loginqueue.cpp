@@ -0,0 +1,111 @@
+/**
+ * The Forgotten Server - a free and open-source MMORPG server emulator
+ * Copyright (C) 2019  Mark Samman <mark.samman@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "otpch.h"
+
+#include "loginqueue.h"
+
+void LoginQueue::start(size_t threadCount)
+{
+	{
+		std::lock_guard<std::mutex> lockClass(taskLock);
+		running = true;
+	}
+
+	threads.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; ++i) {
+		threads.emplace_back(&LoginQueue::threadMain, this);
+	}
+}
+
+void LoginQueue::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lockClass(taskLock);
+		running = false;
+	}
+	taskSignal.notify_all();
+}
+
+void LoginQueue::join()
+{
+	for (std::thread& thread : threads) {
+		if (thread.joinable()) {
+			thread.join();
+		}
+	}
+}
+
+void LoginQueue::addTask(std::function<void (void)> task)
+{
+	if (threads.empty()) {
+		// not started, run it on the calling thread
+		task();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lockClass(taskLock);
+		tasks.push_back({std::move(task), std::chrono::steady_clock::now()});
+		stats.queued = tasks.size();
+		stats.maxQueued = std::max(stats.maxQueued, stats.queued);
+	}
+	taskSignal.notify_one();
+}
+
+LoginQueueStats LoginQueue::getStats() const
+{
+	std::lock_guard<std::mutex> lockClass(taskLock);
+	return stats;
+}
+
+void LoginQueue::threadMain()
+{
+	std::unique_lock<std::mutex> taskLockUnique(taskLock, std::defer_lock);
+	while (true) {
+		taskLockUnique.lock();
+		while (tasks.empty()) {
+			if (!running) {
+				// queued handshakes are always finished before the threads exit
+				return;
+			}
+			taskSignal.wait(taskLockUnique);
+		}
+
+		QueuedTask queuedTask = std::move(tasks.front());
+		tasks.pop_front();
+		stats.queued = tasks.size();
+		taskLockUnique.unlock();
+
+		auto start = std::chrono::steady_clock::now();
+		queuedTask.task();
+		auto end = std::chrono::steady_clock::now();
+
+		uint64_t wait = std::chrono::duration_cast<std::chrono::microseconds>(start - queuedTask.queued).count();
+		uint64_t service = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+		taskLockUnique.lock();
+		++stats.processed;
+		stats.waitMicroseconds += wait;
+		stats.maxWaitMicroseconds = std::max(stats.maxWaitMicroseconds, wait);
+		stats.serviceMicroseconds += service;
+		taskLockUnique.unlock();
+	}
+}
@@ -0,0 +1,76 @@
+/**
+ * The Forgotten Server - a free and open-source MMORPG server emulator
+ * Copyright (C) 2019  Mark Samman <mark.samman@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef FS_LOGINQUEUE_H_1D5ACD9CA62A4B9D99CB9345CC54B2C7
+#define FS_LOGINQUEUE_H_1D5ACD9CA62A4B9D99CB9345CC54B2C7
+
+#include <condition_variable>
+#include <deque>
+
+struct LoginQueueStats {
+	uint64_t processed = 0;
+	uint64_t waitMicroseconds = 0;
+	uint64_t maxWaitMicroseconds = 0;
+	uint64_t serviceMicroseconds = 0;
+	size_t queued = 0;
+	size_t maxQueued = 0;
+};
+
+// Runs the login and game handshakes (RSA decryption and account queries)
+// on a small fixed set of threads. Handshakes are admitted in arrival order
+// and never dropped, a login storm only makes the queue longer.
+class LoginQueue
+{
+	public:
+		LoginQueue() = default;
+
+		// non-copyable
+		LoginQueue(const LoginQueue&) = delete;
+		LoginQueue& operator=(const LoginQueue&) = delete;
+
+		void start(size_t threadCount);
+		void shutdown();
+		void join();
+
+		void addTask(std::function<void (void)> task);
+
+		LoginQueueStats getStats() const;
+
+		void threadMain();
+
+	private:
+		struct QueuedTask {
+			std::function<void (void)> task;
+			std::chrono::steady_clock::time_point queued;
+		};
+
+		std::deque<QueuedTask> tasks;
+		std::vector<std::thread> threads;
+
+		mutable std::mutex taskLock;
+		std::condition_variable taskSignal;
+
+		LoginQueueStats stats;
+		bool running = false;
+};
+
+extern LoginQueue g_loginQueue;
+
+#endif
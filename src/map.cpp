@@ -22,15 +22,26 @@
 #include "iomap.h"
 #include "iomapserialize.h"
 #include "combat.h"
+#include "configmanager.h"
 #include "creature.h"
 #include "game.h"
+#include "monster.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SPECTATOR_SSE2
+#endif
+
+extern ConfigManager g_config;
 extern Game g_game;
 
 bool Map::loadMap(const std::string& identifier, bool loadHouses)
 {
+	// only the main map is loaded lazily, maps loaded on top of it are built at once
+	bool lazy = loadHouses && g_config.getBoolean(ConfigManager::MAP_LAZY_LOADING);
+
 	IOMap loader;
-	if (!loader.loadMap(this, identifier)) {
+	if (!loader.loadMap(this, identifier, lazy)) {
 		std::cout << "[Fatal - Map::loadMap] " << loader.getLastErrorString() << std::endl;
 		return false;
 	}
@@ -39,6 +50,19 @@ bool Map::loadMap(const std::string& identifier, bool loadHouses)
 		std::cout << "[Warning - Map::loadMap] Failed to load spawn data." << std::endl;
 	}
 
+	if (lazy) {
+		// where players log in and monsters spawn is built at startup, the rest on first use
+		for (const auto& it : towns.getTowns()) {
+			const Position& templePos = it.second->getTemplePosition();
+			loadRegions(templePos, 0);
+		}
+
+		for (const Spawn& spawn : spawns.getSpawnList()) {
+			loadRegions(spawn.getCenterPos(), spawn.getRadius());
+		}
+		std::cout << "> Map regions left to build on first use: " << getPendingRegionCount() << '.' << std::endl;
+	}
+
 	if (loadHouses) {
 		if (!IOMap::loadHouses(this)) {
 			std::cout << "[Warning - Map::loadMap] Failed to load house data." << std::endl;
@@ -80,16 +104,15 @@ Tile* Map::getTile(uint16_t x, uint16_t y, uint8_t z) const
 		return nullptr;
 	}
 
-	const QTreeLeafNode* leaf = QTreeNode::getLeafStatic<const QTreeLeafNode*, const QTreeNode*>(&root, x, y);
-	if (!leaf) {
-		return nullptr;
-	}
-
-	const Floor* floor = leaf->getFloor(z);
-	if (!floor) {
-		return nullptr;
+	const QTreeLeafNode* leaf = findLeaf(x, y);
+	const Floor* floor = leaf ? leaf->getFloor(z) : nullptr;
+	Tile* tile = floor ? floor->tiles[x & FLOOR_MASK][y & FLOOR_MASK] : nullptr;
+	if (!tile && isRegionPending(x, y, z)) {
+		// building the region adds tiles, which callers of a const lookup do not see as a change
+		const_cast<Map*>(this)->loadRegion(x, y, z);
+		return getTile(x, y, z);
 	}
-	return floor->tiles[x & FLOOR_MASK][y & FLOOR_MASK];
+	return tile;
 }
 
 void Map::setTile(uint16_t x, uint16_t y, uint8_t z, Tile* newTile)
@@ -99,10 +122,16 @@ void Map::setTile(uint16_t x, uint16_t y, uint8_t z, Tile* newTile)
 		return;
 	}
 
+	if (isRegionPending(x, y, z)) {
+		loadRegion(x, y, z);
+	}
+
 	QTreeLeafNode::newLeaf = false;
 	QTreeLeafNode* leaf = root.createLeaf(x, y, 15);
 
 	if (QTreeLeafNode::newLeaf) {
+		indexLeaf(x, y, leaf);
+
 		//update north
 		QTreeLeafNode* northLeaf = root.getLeaf(x, y - FLOOR_SIZE);
 		if (northLeaf) {
@@ -151,6 +180,224 @@ void Map::setTile(uint16_t x, uint16_t y, uint8_t z, Tile* newTile)
 	} else {
 		tile = newTile;
 	}
+
+	updateTileBits(*tile);
+}
+
+Tile* Map::getPathTile(uint16_t x, uint16_t y, uint8_t z) const
+{
+	if (z >= MAP_MAX_LAYERS) {
+		return nullptr;
+	}
+
+	const QTreeLeafNode* leaf = findLeaf(x, y);
+	const Floor* floor = leaf ? leaf->getFloor(z) : nullptr;
+	if (!floor || (floor->blockPath & Floor::getBit(x, y))) {
+		if (isRegionPending(x, y, z)) {
+			const_cast<Map*>(this)->loadRegion(x, y, z);
+			return getPathTile(x, y, z);
+		}
+		return nullptr;
+	}
+	return floor->tiles[x & FLOOR_MASK][y & FLOOR_MASK];
+}
+
+bool Map::isProjectileBlocked(uint16_t x, uint16_t y, uint8_t z) const
+{
+	if (z >= MAP_MAX_LAYERS) {
+		return false;
+	}
+
+	const QTreeLeafNode* leaf = findLeaf(x, y);
+	const Floor* floor = leaf ? leaf->getFloor(z) : nullptr;
+	if (floor && (floor->blockProjectile & Floor::getBit(x, y))) {
+		return true;
+	}
+
+	if (isRegionPending(x, y, z)) {
+		const_cast<Map*>(this)->loadRegion(x, y, z);
+		return isProjectileBlocked(x, y, z);
+	}
+	return false;
+}
+
+void Map::updateTileBits(const Tile& tile)
+{
+	const Position& pos = tile.getPosition();
+	if (pos.z >= MAP_MAX_LAYERS) {
+		return;
+	}
+
+	QTreeLeafNode* leaf = findLeaf(pos.x, pos.y);
+	if (!leaf) {
+		return;
+	}
+
+	// tiles that are still being loaded are not in the map yet, setTile updates them once they are
+	Floor* floor = leaf->array[pos.z];
+	if (!floor || floor->tiles[pos.x & FLOOR_MASK][pos.y & FLOOR_MASK] != &tile) {
+		return;
+	}
+
+	// the checks of Tile::queryAdd that fail for any creature when pathfinding
+	const uint64_t bit = Floor::getBit(pos.x, pos.y);
+	if (!tile.getGround() || tile.hasFlag(TILESTATE_FLOORCHANGE | TILESTATE_TELEPORT | TILESTATE_IMMOVABLEBLOCKSOLID)) {
+		floor->blockPath |= bit;
+	} else {
+		floor->blockPath &= ~bit;
+	}
+
+	if (tile.hasProperty(CONST_PROP_BLOCKPROJECTILE)) {
+		floor->blockProjectile |= bit;
+	} else {
+		floor->blockProjectile &= ~bit;
+	}
+}
+
+void Map::getTileMemoryUsage(size_t& tiles, size_t& bytes) const
+{
+	tiles = 0;
+	bytes = 0;
+
+	std::vector<const QTreeNode*> nodes {&root};
+	while (!nodes.empty()) {
+		const QTreeNode* node = nodes.back();
+		nodes.pop_back();
+
+		if (!node->isLeaf()) {
+			for (const QTreeNode* child : node->child) {
+				if (child) {
+					nodes.push_back(child);
+				}
+			}
+			continue;
+		}
+
+		const QTreeLeafNode* leaf = static_cast<const QTreeLeafNode*>(node);
+		for (const Floor* floor : leaf->array) {
+			if (!floor) {
+				continue;
+			}
+
+			bytes += sizeof(Floor);
+			for (const auto& row : floor->tiles) {
+				for (const Tile* tile : row) {
+					if (tile) {
+						++tiles;
+						bytes += tile->getMemoryUsage();
+					}
+				}
+			}
+		}
+	}
+}
+
+void Map::createLeafIndex(uint32_t mapWidth, uint32_t mapHeight)
+{
+	leafChunks.clear();
+	leafChunksX = 0;
+	leafChunksY = 0;
+
+	if (!g_config.getBoolean(ConfigManager::MAP_LEAF_INDEX)) {
+		return;
+	}
+
+	const uint32_t chunkTiles = FLOOR_SIZE * LEAF_CHUNK_SIZE;
+	leafChunksX = (std::min<uint32_t>(mapWidth, 0x10000) + chunkTiles - 1) / chunkTiles;
+	leafChunksY = (std::min<uint32_t>(mapHeight, 0x10000) + chunkTiles - 1) / chunkTiles;
+	leafChunks.resize(leafChunksX * leafChunksY);
+}
+
+void Map::addPendingArea(uint16_t x, uint16_t y, uint8_t z, const OTB::Node& node)
+{
+	if (pendingAreas.empty() || pendingAreas.back().node != &node) {
+		pendingAreas.push_back({&node, false});
+	}
+
+	if (pendingRegionBits.empty()) {
+		pendingRegionBits.resize(1 << (2 * (16 - MAP_REGION_BITS) + 4));
+	}
+
+	uint32_t key = getRegionKey(x, y, z);
+	size_t index = pendingAreas.size() - 1;
+	std::vector<size_t>& areas = pendingRegions[key];
+	if (areas.empty() || areas.back() != index) {
+		areas.push_back(index);
+	}
+	pendingRegionBits[key] = true;
+}
+
+bool Map::loadRegion(uint16_t x, uint16_t y, uint8_t z)
+{
+	if (z >= MAP_MAX_LAYERS || !isRegionPending(x, y, z)) {
+		return false;
+	}
+
+	// cleared first, building the region sets its tiles through setTile
+	uint32_t key = getRegionKey(x, y, z);
+	pendingRegionBits[key] = false;
+
+	auto it = pendingRegions.find(key);
+	std::vector<size_t> areas = std::move(it->second);
+	pendingRegions.erase(it);
+
+	// an area reaching into another pending region builds that one from within setTile
+	++regionLoadDepth;
+	for (size_t index : areas) {
+		if (pendingAreas[index].loaded) {
+			continue;
+		}
+
+		pendingAreas[index].loaded = true;
+
+		IOMap loader;
+		if (!loader.loadTileArea(*regionLoader, *pendingAreas[index].node, *this)) {
+			std::cout << "[Error - Map::loadRegion] " << loader.getLastErrorString() << std::endl;
+		}
+	}
+	--regionLoadDepth;
+
+	if (pendingRegions.empty() && regionLoadDepth == 0) {
+		pendingAreas.clear();
+		pendingAreas.shrink_to_fit();
+		pendingRegionBits.clear();
+		pendingRegionBits.shrink_to_fit();
+		regionLoader.reset();
+	}
+	return true;
+}
+
+void Map::loadRegions(const Position& centerPos, int32_t radius)
+{
+	if (pendingRegions.empty()) {
+		return;
+	}
+
+	const int32_t regionSize = 1 << MAP_REGION_BITS;
+	int32_t startX = std::max<int32_t>(0, centerPos.x - radius) & ~(regionSize - 1);
+	int32_t startY = std::max<int32_t>(0, centerPos.y - radius) & ~(regionSize - 1);
+	int32_t endX = std::min<int32_t>(0xFFFF, centerPos.x + radius);
+	int32_t endY = std::min<int32_t>(0xFFFF, centerPos.y + radius);
+	for (int32_t y = startY; y <= endY; y += regionSize) {
+		for (int32_t x = startX; x <= endX; x += regionSize) {
+			loadRegion(x, y, centerPos.z);
+		}
+	}
+}
+
+void Map::indexLeaf(uint16_t x, uint16_t y, QTreeLeafNode* leaf)
+{
+	uint32_t chunkX = x >> (FLOOR_BITS + LEAF_CHUNK_BITS);
+	uint32_t chunkY = y >> (FLOOR_BITS + LEAF_CHUNK_BITS);
+	if (chunkX >= leafChunksX || chunkY >= leafChunksY) {
+		return;
+	}
+
+	std::unique_ptr<LeafChunk>& chunk = leafChunks[chunkY * leafChunksX + chunkX];
+	if (!chunk) {
+		chunk.reset(new LeafChunk());
+	}
+	chunk->leaves[(y >> FLOOR_BITS) & LEAF_CHUNK_MASK][(x >> FLOOR_BITS) & LEAF_CHUNK_MASK] = leaf;
 }
 
 bool Map::placeCreature(const Position& centerPos, Creature* creature, bool extendedPos/* = false*/, bool forceLogin/* = false*/)
@@ -221,7 +468,7 @@ bool Map::placeCreature(const Position& centerPos, Creature* creature, bool exte
 	toCylinder->internalAddThing(creature);
 
 	const Position& dest = toCylinder->getPosition();
-	getQTNode(dest.x, dest.y)->addCreature(creature);
+	getQTNode(dest.x, dest.y)->addCreature(creature, dest);
 	return true;
 }
 
@@ -234,7 +481,7 @@ void Map::moveCreature(Creature& creature, Tile& newTile, bool forceTeleport/* =
 
 	bool teleport = forceTeleport || !newTile.getGround() || !Position::areInRange<1, 1, 0>(oldPos, newPos);
 
-	SpectatorHashSet spectators;
+	SpectatorVec spectators;
 	getSpectators(spectators, oldPos, true);
 	getSpectators(spectators, newPos, true);
 
@@ -258,7 +505,9 @@ void Map::moveCreature(Creature& creature, Tile& newTile, bool forceTeleport/* =
 	// Switch the node ownership
 	if (leaf != new_leaf) {
 		leaf->removeCreature(&creature);
-		new_leaf->addCreature(&creature);
+		new_leaf->addCreature(&creature, newPos);
+	} else {
+		leaf->moveCreature(&creature, newPos);
 	}
 
 	//add the creature
@@ -278,14 +527,22 @@ void Map::moveCreature(Creature& creature, Tile& newTile, bool forceTeleport/* =
 		}
 	}
 
-	//send to client
+	//send to client, spectators that see the same old stackpos share one encoded step
+	NetworkMessage moveMessage;
+	int32_t moveMessageStackPos = -1;
+
 	size_t i = 0;
 	for (Creature* spectator : spectators) {
 		if (Player* tmpPlayer = spectator->getPlayer()) {
 			//Use the correct stackpos
 			int32_t stackpos = oldStackPosVector[i++];
 			if (stackpos != -1) {
-				tmpPlayer->sendCreatureMove(&creature, newPos, newTile.getStackposOfCreature(tmpPlayer, &creature), oldPos, stackpos, teleport);
+				if (stackpos != moveMessageStackPos) {
+					moveMessage.reset();
+					ProtocolGame::AddCreatureMove(moveMessage, oldPos, stackpos, newPos);
+					moveMessageStackPos = stackpos;
+				}
+				tmpPlayer->sendCreatureMove(&creature, newPos, newTile.getStackposOfCreature(tmpPlayer, &creature), oldPos, stackpos, teleport, &moveMessage);
 			}
 		}
 	}
@@ -299,7 +556,35 @@ void Map::moveCreature(Creature& creature, Tile& newTile, bool forceTeleport/* =
 	newTile.postAddNotification(&creature, &oldTile, 0);
 }
 
-void Map::getSpectatorsInternal(SpectatorHashSet& spectators, const Position& centerPos, int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY, int32_t minRangeZ, int32_t maxRangeZ, bool onlyPlayers) const
+// a floor sees at most this many floors above or below it, see getSpectatorFloors
+static constexpr int32_t SPECTATOR_MAX_FLOOR_OFFSET = 7;
+static_assert(MAP_MAX_LAYERS <= 16, "spectator cache floor masks are 16 bit");
+
+static void getSpectatorFloors(uint8_t z, bool multifloor, int32_t& minRangeZ, int32_t& maxRangeZ)
+{
+	if (!multifloor) {
+		minRangeZ = z;
+		maxRangeZ = z;
+	} else if (z > 7) {
+		//underground
+
+		//8->15
+		minRangeZ = std::max<int32_t>(z - 2, 0);
+		maxRangeZ = std::min<int32_t>(z + 2, MAP_MAX_LAYERS - 1);
+	} else if (z == 6) {
+		minRangeZ = 0;
+		maxRangeZ = 8;
+	} else if (z == 7) {
+		minRangeZ = 0;
+		maxRangeZ = 9;
+	} else {
+		minRangeZ = 0;
+		maxRangeZ = 7;
+	}
+}
+
+template<typename Container>
+void Map::getSpectatorsInternal(Container& spectators, const Position& centerPos, int32_t minRangeX, int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY, int32_t minRangeZ, int32_t maxRangeZ, bool onlyPlayers) const
 {
 	int_fast16_t min_y = centerPos.y + minRangeY;
 	int_fast16_t min_x = centerPos.x + minRangeX;
@@ -319,7 +604,7 @@ void Map::getSpectatorsInternal(SpectatorHashSet& spectators, const Position& ce
 	int32_t endx2 = x2 - (x2 % FLOOR_SIZE);
 	int32_t endy2 = y2 - (y2 % FLOOR_SIZE);
 
-	const QTreeLeafNode* startLeaf = QTreeNode::getLeafStatic<const QTreeLeafNode*, const QTreeNode*>(&root, startx1, starty1);
+	const QTreeLeafNode* startLeaf = findLeaf(startx1, starty1);
 	const QTreeLeafNode* leafS = startLeaf;
 	const QTreeLeafNode* leafE;
 
@@ -327,131 +612,120 @@ void Map::getSpectatorsInternal(SpectatorHashSet& spectators, const Position& ce
 		leafE = leafS;
 		for (int_fast32_t nx = startx1; nx <= endx2; nx += FLOOR_SIZE) {
 			if (leafE) {
-				const CreatureVector& node_list = (onlyPlayers ? leafE->player_list : leafE->creature_list);
-				for (Creature* creature : node_list) {
-					const Position& cpos = creature->getPosition();
-					if (minRangeZ > cpos.z || maxRangeZ < cpos.z) {
-						continue;
-					}
-
-					int_fast16_t offsetZ = Position::getOffsetZ(centerPos, cpos);
-					if ((min_y + offsetZ) > cpos.y || (max_y + offsetZ) < cpos.y || (min_x + offsetZ) > cpos.x || (max_x + offsetZ) < cpos.x) {
-						continue;
-					}
-
-					spectators.insert(creature);
-				}
+				const CreaturePositionList& node_list = (onlyPlayers ? leafE->player_list : leafE->creature_list);
+				node_list.filter(spectators, centerPos, min_x, max_x, min_y, max_y, minRangeZ, maxRangeZ);
 				leafE = leafE->leafE;
 			} else {
-				leafE = QTreeNode::getLeafStatic<const QTreeLeafNode*, const QTreeNode*>(&root, nx + FLOOR_SIZE, ny);
+				leafE = findLeaf(nx + FLOOR_SIZE, ny);
 			}
 		}
 
 		if (leafS) {
 			leafS = leafS->leafS;
 		} else {
-			leafS = QTreeNode::getLeafStatic<const QTreeLeafNode*, const QTreeNode*>(&root, startx1, ny + FLOOR_SIZE);
+			leafS = findLeaf(startx1, ny + FLOOR_SIZE);
 		}
 	}
 }
 
-void Map::getSpectators(SpectatorHashSet& spectators, const Position& centerPos, bool multifloor /*= false*/, bool onlyPlayers /*= false*/, int32_t minRangeX /*= 0*/, int32_t maxRangeX /*= 0*/, int32_t minRangeY /*= 0*/, int32_t maxRangeY /*= 0*/)
+void Map::getSpectators(SpectatorVec& spectators, const Position& centerPos, bool multifloor /*= false*/, bool onlyPlayers /*= false*/, int32_t minRangeX /*= 0*/, int32_t maxRangeX /*= 0*/, int32_t minRangeY /*= 0*/, int32_t maxRangeY /*= 0*/)
 {
 	if (centerPos.z >= MAP_MAX_LAYERS) {
 		return;
 	}
 
-	bool foundCache = false;
-	bool cacheResult = false;
-
 	minRangeX = (minRangeX == 0 ? -maxViewportX : -minRangeX);
 	maxRangeX = (maxRangeX == 0 ? maxViewportX : maxRangeX);
 	minRangeY = (minRangeY == 0 ? -maxViewportY : -minRangeY);
 	maxRangeY = (maxRangeY == 0 ? maxViewportY : maxRangeY);
 
-	if (minRangeX == -maxViewportX && maxRangeX == maxViewportX && minRangeY == -maxViewportY && maxRangeY == maxViewportY && multifloor) {
-		if (onlyPlayers) {
-			auto it = playersSpectatorCache.find(centerPos);
-			if (it != playersSpectatorCache.end()) {
-				if (!spectators.empty()) {
-					const SpectatorHashSet& cachedSpectators = it->second;
-					spectators.insert(cachedSpectators.begin(), cachedSpectators.end());
-				} else {
-					spectators = it->second;
-				}
+	int32_t minRangeZ;
+	int32_t maxRangeZ;
+	getSpectatorFloors(centerPos.z, multifloor, minRangeZ, maxRangeZ);
 
-				foundCache = true;
-			}
-		}
+	CreatureVector& creatures = spectators.creatures;
+	const size_t existing = creatures.size();
 
-		if (!foundCache) {
-			auto it = spectatorCache.find(centerPos);
-			if (it != spectatorCache.end()) {
-				if (!onlyPlayers) {
-					if (!spectators.empty()) {
-						const SpectatorHashSet& cachedSpectators = it->second;
-						spectators.insert(cachedSpectators.begin(), cachedSpectators.end());
-					} else {
-						spectators = it->second;
-					}
-				} else {
-					const SpectatorHashSet& cachedSpectators = it->second;
-					for (Creature* spectator : cachedSpectators) {
-						if (spectator->getPlayer()) {
-							spectators.insert(spectator);
-						}
-					}
-				}
+	QTreeLeafNode* leaf = nullptr;
+	if (minRangeX >= -maxViewportX && maxRangeX <= maxViewportX && minRangeY >= -maxViewportY && maxRangeY <= maxViewportY) {
+		leaf = getQTNode(centerPos.x, centerPos.y);
+	}
 
-				foundCache = true;
-			} else {
-				cacheResult = true;
-			}
-		}
+	if (leaf) {
+		const CreaturePositionList& candidates = getSpectatorCandidates(*leaf, centerPos.x & ~FLOOR_MASK, centerPos.y & ~FLOOR_MASK, centerPos.z, onlyPlayers);
+		candidates.filter(creatures, centerPos, centerPos.x + minRangeX, centerPos.x + maxRangeX,
+		                  centerPos.y + minRangeY, centerPos.y + maxRangeY, minRangeZ, maxRangeZ);
+	} else {
+		// wider than the viewport, or nothing on the map here
+		getSpectatorsInternal(creatures, centerPos, minRangeX, maxRangeX, minRangeY, maxRangeY, minRangeZ, maxRangeZ, onlyPlayers);
 	}
 
-	if (!foundCache) {
-		int32_t minRangeZ;
-		int32_t maxRangeZ;
+	// the result is kept sorted, the new creatures are unique among themselves but may repeat earlier ones
+	std::sort(creatures.begin(), creatures.end());
+	if (existing != 0) {
+		creatures.erase(std::unique(creatures.begin(), creatures.end()), creatures.end());
+	}
+}
 
-		if (multifloor) {
-			if (centerPos.z > 7) {
-				//underground
+const CreaturePositionList& Map::getSpectatorCandidates(QTreeLeafNode& leaf, uint16_t leafX, uint16_t leafY, uint8_t z, bool onlyPlayers)
+{
+	if (!leaf.spectatorCache) {
+		leaf.spectatorCache.reset(new std::array<QTreeLeafNode::SpectatorCache, MAP_MAX_LAYERS>());
+	}
 
-				//8->15
-				minRangeZ = std::max<int32_t>(centerPos.getZ() - 2, 0);
-				maxRangeZ = std::min<int32_t>(centerPos.getZ() + 2, MAP_MAX_LAYERS - 1);
-			} else if (centerPos.z == 6) {
-				minRangeZ = 0;
-				maxRangeZ = 8;
-			} else if (centerPos.z == 7) {
-				minRangeZ = 0;
-				maxRangeZ = 9;
-			} else {
-				minRangeZ = 0;
-				maxRangeZ = 7;
-			}
-		} else {
-			minRangeZ = centerPos.z;
-			maxRangeZ = centerPos.z;
-		}
+	QTreeLeafNode::SpectatorCache& cache = (*leaf.spectatorCache)[z];
+	CreaturePositionList& candidates = onlyPlayers ? cache.players : cache.creatures;
+	uint16_t& validFloors = onlyPlayers ? leaf.validPlayerFloors : leaf.validCreatureFloors;
+	if (validFloors & (1 << z)) {
+		return candidates;
+	}
 
-		getSpectatorsInternal(spectators, centerPos, minRangeX, maxRangeX, minRangeY, maxRangeY, minRangeZ, maxRangeZ, onlyPlayers);
+	// the viewport around every position of the leaf, on every floor a position on z may see
+	int32_t minRangeZ;
+	int32_t maxRangeZ;
+	getSpectatorFloors(z, true, minRangeZ, maxRangeZ);
 
-		if (cacheResult) {
-			if (onlyPlayers) {
-				playersSpectatorCache[centerPos] = spectators;
+	candidates.clear();
+	getSpectatorsInternal(candidates, Position(leafX, leafY, z), -maxViewportX, maxViewportX + FLOOR_SIZE - 1,
+	                      -maxViewportY, maxViewportY + FLOOR_SIZE - 1, minRangeZ, maxRangeZ, onlyPlayers);
+	validFloors |= (1 << z);
+	return candidates;
+}
+
+void Map::invalidateSpectatorCache(const Position& pos)
+{
+	// every leaf whose candidates could include pos, on any floor
+	int32_t x1 = std::max<int32_t>(0, pos.x - maxViewportX - (FLOOR_SIZE - 1) - SPECTATOR_MAX_FLOOR_OFFSET);
+	int32_t y1 = std::max<int32_t>(0, pos.y - maxViewportY - (FLOOR_SIZE - 1) - SPECTATOR_MAX_FLOOR_OFFSET);
+	int32_t x2 = std::min<int32_t>(0xFFFF, pos.x + maxViewportX + SPECTATOR_MAX_FLOOR_OFFSET);
+	int32_t y2 = std::min<int32_t>(0xFFFF, pos.y + maxViewportY + SPECTATOR_MAX_FLOOR_OFFSET);
+
+	int32_t startx1 = x1 - (x1 % FLOOR_SIZE);
+	int32_t starty1 = y1 - (y1 % FLOOR_SIZE);
+	int32_t endx2 = x2 - (x2 % FLOOR_SIZE);
+	int32_t endy2 = y2 - (y2 % FLOOR_SIZE);
+
+	QTreeLeafNode* leafS = findLeaf(startx1, starty1);
+	QTreeLeafNode* leafE;
+
+	for (int_fast32_t ny = starty1; ny <= endy2; ny += FLOOR_SIZE) {
+		leafE = leafS;
+		for (int_fast32_t nx = startx1; nx <= endx2; nx += FLOOR_SIZE) {
+			if (leafE) {
+				leafE->validCreatureFloors = 0;
+				leafE->validPlayerFloors = 0;
+				leafE = leafE->leafE;
 			} else {
-				spectatorCache[centerPos] = spectators;
+				leafE = findLeaf(nx + FLOOR_SIZE, ny);
 			}
 		}
-	}
-}
 
-void Map::clearSpectatorCache()
-{
-	spectatorCache.clear();
-	playersSpectatorCache.clear();
+		if (leafS) {
+			leafS = leafS->leafS;
+		} else {
+			leafS = findLeaf(startx1, ny + FLOOR_SIZE);
+		}
+	}
 }
 
 bool Map::canThrowObjectTo(const Position& fromPos, const Position& toPos, bool checkLineOfSight /*= true*/,
@@ -513,8 +787,7 @@ bool Map::checkSightLine(const Position& fromPos, const Position& toPos) const
 			start.x += mx;
 		}
 
-		const Tile* tile = getTile(start.x, start.y, start.z);
-		if (tile && tile->hasProperty(CONST_PROP_BLOCKPROJECTILE)) {
+		if (isProjectileBlocked(start.x, start.y, start.z)) {
 			return false;
 		}
 	}
@@ -736,21 +1009,255 @@ bool Map::getPathMatching(const Creature& creature, std::forward_list<Direction>
 	return true;
 }
 
+static const struct {
+	int_fast32_t x, y;
+	Direction direction;
+} followSteps[8] = {
+	{0, -1, DIRECTION_NORTH}, {1, 0, DIRECTION_EAST}, {0, 1, DIRECTION_SOUTH}, {-1, 0, DIRECTION_WEST},
+	{-1, -1, DIRECTION_NORTHWEST}, {1, -1, DIRECTION_NORTHEAST}, {-1, 1, DIRECTION_SOUTHWEST}, {1, 1, DIRECTION_SOUTHEAST}
+};
+
+static int_fast32_t getFollowStepCost(size_t step)
+{
+	return step < 4 ? MAP_NORMALWALKCOST : MAP_DIAGONALWALKCOST;
+}
+
+bool Map::getFollowPath(const Creature& creature, const Position& targetPos, std::forward_list<Direction>& dirList, const FindPathParams& fpp)
+{
+	const Position& startPos = creature.getPosition();
+	const Monster* monster = creature.getMonster();
+
+	int32_t targetDist = std::max<int32_t>(Position::getDistanceX(startPos, targetPos), Position::getDistanceY(startPos, targetPos));
+	if (!monster || fpp.keepDistance || !fpp.fullPathSearch || fpp.minTargetDist != 1 || fpp.maxTargetDist != 1 ||
+	        fpp.maxSearchDist <= 0 || startPos.z != targetPos.z || targetDist <= 1 || targetDist > fpp.maxSearchDist) {
+		return getPathMatching(creature, dirList, FrozenPathingConditionCall(targetPos), fpp);
+	}
+
+	// everything that changes where this monster may walk or what a step costs
+	uint8_t flags = 0;
+	if (fpp.allowDiagonal) {
+		flags |= 1 << 0;
+	}
+	if (monster->isSummon()) {
+		flags |= 1 << 1;
+	}
+	if (monster->isIgnoringFieldDamage()) {
+		flags |= 1 << 2;
+	}
+	if (creature.hasCondition(CONDITION_FIRE)) {
+		flags |= 1 << 3;
+	}
+	if (creature.hasCondition(CONDITION_ENERGY)) {
+		flags |= 1 << 4;
+	}
+	if (creature.hasCondition(CONDITION_POISON)) {
+		flags |= 1 << 5;
+	}
+
+	FollowPathKey key{targetPos, monster->getMonsterType(), fpp.maxSearchDist, flags};
+
+	int64_t now = OTSYS_TIME();
+	auto it = followPathFields.find(key);
+	if (it == followPathFields.end()) {
+		if (followPathFields.size() >= FOLLOW_PATH_FIELD_SWEEP_SIZE) {
+			for (auto fieldIt = followPathFields.begin(); fieldIt != followPathFields.end();) {
+				if (now - fieldIt->second.created >= FOLLOW_PATH_FIELD_DURATION) {
+					fieldIt = followPathFields.erase(fieldIt);
+				} else {
+					++fieldIt;
+				}
+			}
+		}
+		it = followPathFields.emplace(key, FollowPathField()).first;
+	}
+
+	FollowPathField& field = it->second;
+	if (now - field.created >= FOLLOW_PATH_FIELD_DURATION) {
+		field.created = now;
+		field.requests = 0;
+		field.costs.clear();
+	}
+
+	if (++field.requests == 1) {
+		// a lone chaser is cheaper to serve with its own search
+		return getPathMatching(creature, dirList, FrozenPathingConditionCall(targetPos), fpp);
+	}
+
+	if (field.costs.empty()) {
+		// the window covers the whole search area of any chaser within maxSearchDist
+		field.radius = fpp.maxSearchDist * 2;
+		searchFollowPathField(field, *monster, targetPos, fpp.allowDiagonal);
+	}
+
+	// The field may route through tiles this chaser would never search, so the route is searched again
+	// within the chaser's own maxSearchDist box and node limit. The field costs are the cheapest way to the
+	// target from each tile, which steers this search straight along the best route inside the box.
+	// Only the first step is checked against the map as it is right now.
+	const int_fast32_t searchDist = fpp.maxSearchDist;
+	const int_fast32_t searchSide = searchDist * 2 + 1;
+	auto getSearchIndex = [&](int_fast32_t x, int_fast32_t y) -> int32_t {
+		int_fast32_t offsetX = x - startPos.x + searchDist;
+		int_fast32_t offsetY = y - startPos.y + searchDist;
+		if (offsetX < 0 || offsetY < 0 || offsetX >= searchSide || offsetY >= searchSide) {
+			return -1;
+		}
+		return offsetY * searchSide + offsetX;
+	};
+
+	// cost from the start and the step that reached each tile of the box, -1 where not reached yet
+	std::vector<int32_t> searchCosts(searchSide * searchSide, -1);
+	std::vector<int8_t> searchSteps(searchSide * searchSide, -1);
+
+	using QueuedTile = std::pair<int32_t, int32_t>;
+	std::priority_queue<QueuedTile, std::vector<QueuedTile>, std::greater<QueuedTile>> queue;
+
+	const int32_t startIndex = getSearchIndex(startPos.x, startPos.y);
+	searchCosts[startIndex] = 0;
+	queue.emplace(0, startIndex);
+	int32_t nodeCount = 1;
+
+	const size_t stepCount = fpp.allowDiagonal ? 8 : 4;
+	while (!queue.empty()) {
+		QueuedTile queued = queue.top();
+		queue.pop();
+
+		int32_t searchIndex = queued.second;
+		int_fast32_t x = startPos.x - searchDist + (searchIndex % searchSide);
+		int_fast32_t y = startPos.y - searchDist + (searchIndex / searchSide);
+		int32_t index = field.getIndex(targetPos, x, y);
+		int32_t remaining = searchIndex == startIndex ? 0 : field.costs[index];
+		if (queued.first != searchCosts[searchIndex] + remaining) {
+			continue;
+		}
+
+		if (searchIndex != startIndex && remaining == 0) {
+			do {
+				const auto& step = followSteps[searchSteps[searchIndex]];
+				dirList.push_front(step.direction);
+				x -= step.x;
+				y -= step.y;
+				searchIndex = getSearchIndex(x, y);
+			} while (searchIndex != startIndex);
+			return true;
+		}
+
+		for (size_t step = 0; step < stepCount; ++step) {
+			int_fast32_t toX = x + followSteps[step].x;
+			int_fast32_t toY = y + followSteps[step].y;
+
+			int32_t toSearchIndex = getSearchIndex(toX, toY);
+			int32_t toIndex = field.getIndex(targetPos, toX, toY);
+			if (toSearchIndex < 0 || toIndex < 0 || field.costs[toIndex] < 0) {
+				continue;
+			}
+
+			int32_t toCost = searchCosts[searchIndex] + field.extraCosts[toIndex] + getFollowStepCost(step);
+			if (searchCosts[toSearchIndex] >= 0 && searchCosts[toSearchIndex] <= toCost) {
+				continue;
+			}
+
+			if (searchIndex == startIndex && !canWalkTo(creature, Position(toX, toY, startPos.z))) {
+				continue;
+			}
+
+			if (searchCosts[toSearchIndex] < 0 && ++nodeCount > MAX_NODES) {
+				// the search it replaces gives up once it runs out of nodes
+				return false;
+			}
+
+			searchCosts[toSearchIndex] = toCost;
+			searchSteps[toSearchIndex] = step;
+			queue.emplace(toCost + field.costs[toIndex], toSearchIndex);
+		}
+	}
+	return false;
+}
+
+void Map::searchFollowPathField(FollowPathField& field, const Monster& monster, const Position& targetPos, bool allowDiagonal) const
+{
+	enum : uint8_t {TILE_UNKNOWN, TILE_BLOCKED, TILE_WALKABLE};
+
+	const int32_t side = field.radius * 2 + 1;
+	field.costs.assign(side * side, -1);
+	field.extraCosts.assign(side * side, 0);
+	std::vector<uint8_t> tileStates(side * side, TILE_UNKNOWN);
+
+	// every tile is judged as if this monster stood elsewhere, so other chasers block like they do in a search
+	auto isWalkable = [&](int32_t index, int_fast32_t x, int_fast32_t y) {
+		if (tileStates[index] == TILE_UNKNOWN) {
+			const Tile* tile = getTile(x, y, targetPos.z);
+			if (tile && tile->queryAdd(0, monster, 1, FLAG_PATHFINDING | FLAG_IGNOREFIELDDAMAGE) == RETURNVALUE_NOERROR) {
+				tileStates[index] = TILE_WALKABLE;
+				field.extraCosts[index] = AStarNodes::getTileWalkCost(monster, tile);
+			} else {
+				tileStates[index] = TILE_BLOCKED;
+			}
+		}
+		return tileStates[index] == TILE_WALKABLE;
+	};
+
+	using QueuedTile = std::pair<int32_t, int32_t>;
+	std::priority_queue<QueuedTile, std::vector<QueuedTile>, std::greater<QueuedTile>> queue;
+
+	for (const auto& step : followSteps) {
+		int_fast32_t x = targetPos.x + step.x;
+		int_fast32_t y = targetPos.y + step.y;
+		int32_t index = field.getIndex(targetPos, x, y);
+		if (index >= 0 && isWalkable(index, x, y)) {
+			field.costs[index] = 0;
+			queue.emplace(0, index);
+		}
+	}
+
+	const size_t stepCount = allowDiagonal ? 8 : 4;
+	while (!queue.empty()) {
+		QueuedTile queued = queue.top();
+		queue.pop();
+
+		int32_t index = queued.second;
+		if (queued.first != field.costs[index]) {
+			continue;
+		}
+
+		// stepping onto this tile costs its extra cost, whichever tile the step comes from
+		int32_t cost = queued.first + field.extraCosts[index];
+		int_fast32_t x = targetPos.x - field.radius + (index % side);
+		int_fast32_t y = targetPos.y - field.radius + (index / side);
+		for (size_t step = 0; step < stepCount; ++step) {
+			int_fast32_t fromX = x - followSteps[step].x;
+			int_fast32_t fromY = y - followSteps[step].y;
+			int32_t fromIndex = field.getIndex(targetPos, fromX, fromY);
+			if (fromIndex < 0 || !isWalkable(fromIndex, fromX, fromY)) {
+				continue;
+			}
+
+			int32_t fromCost = cost + getFollowStepCost(step);
+			if (field.costs[fromIndex] < 0 || fromCost < field.costs[fromIndex]) {
+				field.costs[fromIndex] = fromCost;
+				queue.emplace(fromCost, fromIndex);
+			}
+		}
+	}
+}
+
 // AStarNodes
 
 AStarNodes::AStarNodes(uint32_t x, uint32_t y)
-	: nodes(), openNodes()
+	: nodeGrid(), startX(x), startY(y)
 {
 	curNode = 1;
 	closedNodes = 0;
-	openNodes[0] = true;
+
+	openCount = 1;
+	openHeap[0] = 0;
+	heapPositions[0] = 0;
 
 	AStarNode& startNode = nodes[0];
 	startNode.parent = nullptr;
 	startNode.x = x;
 	startNode.y = y;
 	startNode.f = 0;
-	nodeTable[(x << 16) | y] = nodes;
+	nodeGrid[getGridIndex(x, y)] = 1;
 }
 
 AStarNode* AStarNodes::createOpenNode(AStarNode* parent, uint32_t x, uint32_t y, int_fast32_t f)
@@ -760,54 +1267,68 @@ AStarNode* AStarNodes::createOpenNode(AStarNode* parent, uint32_t x, uint32_t y,
 	}
 
 	size_t retNode = curNode++;
-	openNodes[retNode] = true;
 
 	AStarNode* node = nodes + retNode;
-	nodeTable[(x << 16) | y] = node;
 	node->parent = parent;
 	node->x = x;
 	node->y = y;
 	node->f = f;
+
+	int32_t gridIndex = getGridIndex(x, y);
+	if (gridIndex >= 0) {
+		nodeGrid[gridIndex] = retNode + 1;
+	}
+
+	openHeap[openCount] = retNode;
+	heapPositions[retNode] = openCount;
+	siftUp(openCount++);
 	return node;
 }
 
 AStarNode* AStarNodes::getBestNode()
 {
-	if (curNode == 0) {
+	if (openCount == 0) {
 		return nullptr;
 	}
-
-	int32_t best_node_f = std::numeric_limits<int32_t>::max();
-	int32_t best_node = -1;
-	for (size_t i = 0; i < curNode; i++) {
-		if (openNodes[i] && nodes[i].f < best_node_f) {
-			best_node_f = nodes[i].f;
-			best_node = i;
-		}
-	}
-
-	if (best_node >= 0) {
-		return nodes + best_node;
-	}
-	return nullptr;
+	return nodes + openHeap[0];
 }
 
 void AStarNodes::closeNode(AStarNode* node)
 {
 	size_t index = node - nodes;
 	assert(index < MAX_NODES);
-	openNodes[index] = false;
 	++closedNodes;
+
+	int16_t position = heapPositions[index];
+	if (position < 0) {
+		return;
+	}
+	heapPositions[index] = -1;
+
+	uint16_t last = openHeap[--openCount];
+	if (static_cast<size_t>(position) != openCount) {
+		openHeap[position] = last;
+		heapPositions[last] = position;
+		siftDown(siftUp(position));
+	}
 }
 
 void AStarNodes::openNode(AStarNode* node)
 {
 	size_t index = node - nodes;
 	assert(index < MAX_NODES);
-	if (!openNodes[index]) {
-		openNodes[index] = true;
-		--closedNodes;
+
+	int16_t position = heapPositions[index];
+	if (position >= 0) {
+		// still open, its f only went down
+		siftUp(position);
+		return;
 	}
+
+	openHeap[openCount] = index;
+	heapPositions[index] = openCount;
+	siftUp(openCount++);
+	--closedNodes;
 }
 
 int_fast32_t AStarNodes::getClosedNodes() const
@@ -817,11 +1338,87 @@ int_fast32_t AStarNodes::getClosedNodes() const
 
 AStarNode* AStarNodes::getNodeByPosition(uint32_t x, uint32_t y)
 {
-	auto it = nodeTable.find((x << 16) | y);
-	if (it == nodeTable.end()) {
-		return nullptr;
+	int32_t gridIndex = getGridIndex(x, y);
+	if (gridIndex >= 0) {
+		uint16_t index = nodeGrid[gridIndex];
+		if (index == 0) {
+			return nullptr;
+		}
+		return nodes + (index - 1);
+	}
+
+	for (size_t i = 0; i < curNode; ++i) {
+		if (nodes[i].x == x && nodes[i].y == y) {
+			return nodes + i;
+		}
+	}
+	return nullptr;
+}
+
+int32_t AStarNodes::getGridIndex(uint32_t x, uint32_t y) const
+{
+	// positions outside the window are only found by scanning all nodes
+	uint32_t gridX = x - startX + (NODE_GRID_SIZE / 2);
+	uint32_t gridY = y - startY + (NODE_GRID_SIZE / 2);
+	if (gridX >= static_cast<uint32_t>(NODE_GRID_SIZE) || gridY >= static_cast<uint32_t>(NODE_GRID_SIZE)) {
+		return -1;
+	}
+	return gridY * NODE_GRID_SIZE + gridX;
+}
+
+bool AStarNodes::isBetterNode(uint16_t index, uint16_t otherIndex) const
+{
+	// on equal cost the node created first wins, this keeps the chosen paths stable
+	const int_fast32_t f = nodes[index].f;
+	const int_fast32_t otherF = nodes[otherIndex].f;
+	return f < otherF || (f == otherF && index < otherIndex);
+}
+
+size_t AStarNodes::siftUp(size_t position)
+{
+	uint16_t index = openHeap[position];
+	while (position > 0) {
+		size_t parent = (position - 1) / 2;
+		uint16_t parentIndex = openHeap[parent];
+		if (!isBetterNode(index, parentIndex)) {
+			break;
+		}
+
+		openHeap[position] = parentIndex;
+		heapPositions[parentIndex] = position;
+		position = parent;
+	}
+
+	openHeap[position] = index;
+	heapPositions[index] = position;
+	return position;
+}
+
+void AStarNodes::siftDown(size_t position)
+{
+	uint16_t index = openHeap[position];
+	while (true) {
+		size_t child = position * 2 + 1;
+		if (child >= openCount) {
+			break;
+		}
+
+		if (child + 1 < openCount && isBetterNode(openHeap[child + 1], openHeap[child])) {
+			++child;
+		}
+
+		uint16_t childIndex = openHeap[child];
+		if (!isBetterNode(childIndex, index)) {
+			break;
+		}
+
+		openHeap[position] = childIndex;
+		heapPositions[childIndex] = position;
+		position = child;
 	}
-	return it->second;
+
+	openHeap[position] = index;
+	heapPositions[index] = position;
 }
 
 int_fast32_t AStarNodes::getMapWalkCost(AStarNode* node, const Position& neighborPos)
@@ -916,30 +1513,129 @@ Floor* QTreeLeafNode::createFloor(uint32_t z)
 	return array[z];
 }
 
-void QTreeLeafNode::addCreature(Creature* c)
+void QTreeLeafNode::addCreature(Creature* c, const Position& pos)
 {
-	creature_list.push_back(c);
+	creature_list.push_back(c, pos);
 
 	if (c->getPlayer()) {
-		player_list.push_back(c);
+		player_list.push_back(c, pos);
 	}
 }
 
 void QTreeLeafNode::removeCreature(Creature* c)
 {
-	auto iter = std::find(creature_list.begin(), creature_list.end(), c);
-	assert(iter != creature_list.end());
-	*iter = creature_list.back();
-	creature_list.pop_back();
+	creature_list.remove(c);
+
+	if (c->getPlayer()) {
+		player_list.remove(c);
+	}
+}
+
+void QTreeLeafNode::moveCreature(Creature* c, const Position& pos)
+{
+	creature_list.setPosition(c, pos);
 
 	if (c->getPlayer()) {
-		iter = std::find(player_list.begin(), player_list.end(), c);
-		assert(iter != player_list.end());
-		*iter = player_list.back();
-		player_list.pop_back();
+		player_list.setPosition(c, pos);
 	}
 }
 
+void CreaturePositionList::remove(Creature* creature)
+{
+	auto it = std::find(creatures.begin(), creatures.end(), creature);
+	assert(it != creatures.end());
+
+	size_t index = it - creatures.begin();
+	*it = creatures.back();
+	creatures.pop_back();
+	x[index] = x.back();
+	x.pop_back();
+	y[index] = y.back();
+	y.pop_back();
+	z[index] = z.back();
+	z.pop_back();
+}
+
+void CreaturePositionList::setPosition(Creature* creature, const Position& pos)
+{
+	auto it = std::find(creatures.begin(), creatures.end(), creature);
+	assert(it != creatures.end());
+
+	size_t index = it - creatures.begin();
+	x[index] = pos.x;
+	y[index] = pos.y;
+	z[index] = pos.z;
+}
+
+template<typename Callback>
+void CreaturePositionList::forEachInRange(const Position& centerPos, int32_t minX, int32_t maxX, int32_t minY, int32_t maxY,
+                                          int32_t minRangeZ, int32_t maxRangeZ, Callback callback) const
+{
+	// a creature on floor z is shifted by centerPos.z - z, so x + z is compared against the
+	// ranges moved by centerPos.z, which keeps the test free of per creature offsets
+	minX += centerPos.z;
+	maxX += centerPos.z;
+	minY += centerPos.z;
+	maxY += centerPos.z;
+
+	const size_t count = creatures.size();
+	size_t i = 0;
+
+#ifdef SPECTATOR_SSE2
+	const __m128i lowX = _mm_set1_epi32(minX - 1), highX = _mm_set1_epi32(maxX + 1);
+	const __m128i lowY = _mm_set1_epi32(minY - 1), highY = _mm_set1_epi32(maxY + 1);
+	const __m128i lowZ = _mm_set1_epi32(minRangeZ - 1), highZ = _mm_set1_epi32(maxRangeZ + 1);
+
+	for (; i + 4 <= count; i += 4) {
+		const __m128i vz = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&z[i]));
+		const __m128i vx = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&x[i])), vz);
+		const __m128i vy = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&y[i])), vz);
+
+		__m128i inRange = _mm_and_si128(_mm_cmpgt_epi32(vz, lowZ), _mm_cmplt_epi32(vz, highZ));
+		inRange = _mm_and_si128(inRange, _mm_and_si128(_mm_cmpgt_epi32(vx, lowX), _mm_cmplt_epi32(vx, highX)));
+		inRange = _mm_and_si128(inRange, _mm_and_si128(_mm_cmpgt_epi32(vy, lowY), _mm_cmplt_epi32(vy, highY)));
+
+		int mask = _mm_movemask_ps(_mm_castsi128_ps(inRange));
+		for (size_t lane = 0; mask != 0; ++lane, mask >>= 1) {
+			if (mask & 1) {
+				callback(i + lane);
+			}
+		}
+	}
+#endif
+
+	for (; i < count; ++i) {
+		if (z[i] < minRangeZ || z[i] > maxRangeZ) {
+			continue;
+		}
+
+		int32_t shiftedX = x[i] + z[i];
+		int32_t shiftedY = y[i] + z[i];
+		if (shiftedX >= minX && shiftedX <= maxX && shiftedY >= minY && shiftedY <= maxY) {
+			callback(i);
+		}
+	}
+}
+
+void CreaturePositionList::filter(CreatureVector& out, const Position& centerPos, int32_t minX, int32_t maxX,
+                                  int32_t minY, int32_t maxY, int32_t minRangeZ, int32_t maxRangeZ) const
+{
+	forEachInRange(centerPos, minX, maxX, minY, maxY, minRangeZ, maxRangeZ, [this, &out](size_t index) {
+		out.push_back(creatures[index]);
+	});
+}
+
+void CreaturePositionList::filter(CreaturePositionList& out, const Position& centerPos, int32_t minX, int32_t maxX,
+                                  int32_t minY, int32_t maxY, int32_t minRangeZ, int32_t maxRangeZ) const
+{
+	forEachInRange(centerPos, minX, maxX, minY, maxY, minRangeZ, maxRangeZ, [this, &out](size_t index) {
+		out.creatures.push_back(creatures[index]);
+		out.x.push_back(x[index]);
+		out.y.push_back(y[index]);
+		out.z.push_back(z[index]);
+	});
+}
+
 uint32_t Map::clean() const
 {
 	uint64_t start = OTSYS_TIME();
@@ -20,6 +20,8 @@
 #ifndef FS_MAP_H_E3953D57C058461F856F5221D359DAFA
 #define FS_MAP_H_E3953D57C058461F856F5221D359DAFA
 
+#include <array>
+
 #include "position.h"
 #include "item.h"
 #include "fileloader.h"
@@ -35,6 +37,8 @@ class Player;
 class Game;
 class Tile;
 class Map;
+class Monster;
+class MonsterType;
 
 static constexpr int32_t MAP_MAX_LAYERS = 16;
 
@@ -46,6 +50,8 @@ struct AStarNode {
 };
 
 static constexpr int32_t MAX_NODES = 512;
+// side of the window around the start position where nodes are indexed directly
+static constexpr int32_t NODE_GRID_SIZE = 64;
 
 static constexpr int32_t MAP_NORMALWALKCOST = 10;
 static constexpr int32_t MAP_DIAGONALWALKCOST = 25;
@@ -66,19 +72,83 @@ class AStarNodes
 		static int_fast32_t getTileWalkCost(const Creature& creature, const Tile* tile);
 
 	private:
+		int32_t getGridIndex(uint32_t x, uint32_t y) const;
+		bool isBetterNode(uint16_t index, uint16_t otherIndex) const;
+		size_t siftUp(size_t position);
+		void siftDown(size_t position);
+
 		AStarNode nodes[MAX_NODES];
-		bool openNodes[MAX_NODES];
-		std::unordered_map<uint32_t, AStarNode*> nodeTable;
+		// binary min-heap of the open node indexes, and where each node sits in it (-1 when closed)
+		uint16_t openHeap[MAX_NODES];
+		int16_t heapPositions[MAX_NODES];
+		// node index + 1 for every position in the window, 0 where there is no node
+		uint16_t nodeGrid[NODE_GRID_SIZE * NODE_GRID_SIZE];
+		uint32_t startX;
+		uint32_t startY;
 		size_t curNode;
+		size_t openCount;
 		int_fast32_t closedNodes;
 };
 
-using SpectatorCache = std::map<Position, SpectatorHashSet>;
+// how long a follow path field is shared before it is searched again
+static constexpr int64_t FOLLOW_PATH_FIELD_DURATION = 500;
+// stale fields are only swept once there are this many
+static constexpr size_t FOLLOW_PATH_FIELD_SWEEP_SIZE = 128;
+
+struct FollowPathKey {
+	Position targetPos;
+	const MonsterType* monsterType;
+	int32_t maxSearchDist;
+	// diagonal steps, summon, field damage handling; see Map::getFollowPath
+	uint8_t flags;
+
+	bool operator==(const FollowPathKey& other) const {
+		return targetPos == other.targetPos && monsterType == other.monsterType &&
+		       maxSearchDist == other.maxSearchDist && flags == other.flags;
+	}
+};
+
+struct FollowPathKeyHash {
+	size_t operator()(const FollowPathKey& key) const {
+		// packed in 64 bits and folded, so that 32-bit builds keep every field
+		uint64_t bits = key.targetPos.x | (static_cast<uint64_t>(key.targetPos.y) << 16) | (static_cast<uint64_t>(key.targetPos.z) << 32) |
+		                (static_cast<uint64_t>(key.flags) << 40) | (static_cast<uint64_t>(static_cast<uint16_t>(key.maxSearchDist)) << 48);
+		return std::hash<const MonsterType*>()(key.monsterType) ^ static_cast<size_t>(bits ^ (bits >> 32));
+	}
+};
+
+// Search from the tiles next to a target outwards, shared by every melee
+// chaser with the same walking rules. costs holds what it takes to reach
+// the target from each tile of the window, -1 where it cannot be reached.
+struct FollowPathField {
+	int64_t created = 0;
+	uint32_t requests = 0;
+	int32_t radius = 0;
+	std::vector<int32_t> costs;
+	std::vector<int32_t> extraCosts;
+
+	int32_t getIndex(const Position& targetPos, int_fast32_t x, int_fast32_t y) const {
+		int_fast32_t offsetX = x - targetPos.x + radius;
+		int_fast32_t offsetY = y - targetPos.y + radius;
+		int_fast32_t side = radius * 2 + 1;
+		if (offsetX < 0 || offsetY < 0 || offsetX >= side || offsetY >= side) {
+			return -1;
+		}
+		return offsetY * side + offsetX;
+	}
+};
 
 static constexpr int32_t FLOOR_BITS = 3;
 static constexpr int32_t FLOOR_SIZE = (1 << FLOOR_BITS);
 static constexpr int32_t FLOOR_MASK = (FLOOR_SIZE - 1);
 
+// a lazily loaded map builds its tile areas by regions of this many tiles per side and floor
+static constexpr int32_t MAP_REGION_BITS = 8;
+
+static constexpr int32_t LEAF_CHUNK_BITS = 5;
+static constexpr int32_t LEAF_CHUNK_SIZE = (1 << LEAF_CHUNK_BITS);
+static constexpr int32_t LEAF_CHUNK_MASK = (LEAF_CHUNK_SIZE - 1);
+
 struct Floor {
 	constexpr Floor() = default;
 	~Floor();
@@ -88,6 +158,65 @@ struct Floor {
 	Floor& operator=(const Floor&) = delete;
 
 	Tile* tiles[FLOOR_SIZE][FLOOR_SIZE] = {};
+
+	// one bit per tile, see Floor::getBit: tiles that no creature can path through (a missing
+	// tile counts as one) and tiles that block projectiles, kept up to date by Map::updateTileBits
+	uint64_t blockPath = ~static_cast<uint64_t>(0);
+	uint64_t blockProjectile = 0;
+
+	static uint64_t getBit(uint16_t x, uint16_t y) {
+		return static_cast<uint64_t>(1) << (((x & FLOOR_MASK) << FLOOR_BITS) | (y & FLOOR_MASK));
+	}
+};
+
+static_assert(FLOOR_SIZE * FLOOR_SIZE == 64, "Floor bitsets are 64 bit");
+
+// Creatures together with a copy of their positions, stored column-wise so range
+// queries can test them in bulk without touching the creatures themselves.
+class CreaturePositionList
+{
+	public:
+		const CreatureVector& getCreatures() const {
+			return creatures;
+		}
+		size_t size() const {
+			return creatures.size();
+		}
+		bool empty() const {
+			return creatures.empty();
+		}
+
+		void push_back(Creature* creature, const Position& pos) {
+			creatures.push_back(creature);
+			x.push_back(pos.x);
+			y.push_back(pos.y);
+			z.push_back(pos.z);
+		}
+		void remove(Creature* creature);
+		void setPosition(Creature* creature, const Position& pos);
+		void clear() {
+			creatures.clear();
+			x.clear();
+			y.clear();
+			z.clear();
+		}
+
+		// Appends every creature with minRangeZ <= z <= maxRangeZ that lies within the
+		// x and y ranges once shifted by its floor offset to centerPos, like the client sees it.
+		void filter(CreatureVector& out, const Position& centerPos, int32_t minX, int32_t maxX,
+		            int32_t minY, int32_t maxY, int32_t minRangeZ, int32_t maxRangeZ) const;
+		void filter(CreaturePositionList& out, const Position& centerPos, int32_t minX, int32_t maxX,
+		            int32_t minY, int32_t maxY, int32_t minRangeZ, int32_t maxRangeZ) const;
+
+	private:
+		template<typename Callback>
+		void forEachInRange(const Position& centerPos, int32_t minX, int32_t maxX, int32_t minY, int32_t maxY,
+		                    int32_t minRangeZ, int32_t maxRangeZ, Callback callback) const;
+
+		CreatureVector creatures;
+		std::vector<int32_t> x;
+		std::vector<int32_t> y;
+		std::vector<int32_t> z;
 };
 
 class FrozenPathingConditionCall;
@@ -150,16 +279,26 @@ class QTreeLeafNode final : public QTreeNode
 			return array[z];
 		}
 
-		void addCreature(Creature* c);
+		void addCreature(Creature* c, const Position& pos);
 		void removeCreature(Creature* c);
+		void moveCreature(Creature* c, const Position& pos);
 
 	private:
 		static bool newLeaf;
 		QTreeLeafNode* leafS = nullptr;
 		QTreeLeafNode* leafE = nullptr;
 		Floor* array[MAP_MAX_LAYERS] = {};
-		CreatureVector creature_list;
-		CreatureVector player_list;
+		CreaturePositionList creature_list;
+		CreaturePositionList player_list;
+
+		// per floor, the creatures that any viewport query centered in this leaf may see
+		struct SpectatorCache {
+			CreaturePositionList creatures;
+			CreaturePositionList players;
+		};
+		std::unique_ptr<std::array<SpectatorCache, MAP_MAX_LAYERS>> spectatorCache;
+		uint16_t validCreatureFloors = 0;
+		uint16_t validPlayerFloors = 0;
 
 		friend class Map;
 		friend class QTreeNode;
@@ -220,11 +359,12 @@ class Map
 
 		void moveCreature(Creature& creature, Tile& newTile, bool forceTeleport = false);
 
-		void getSpectators(SpectatorHashSet& spectators, const Position& centerPos, bool multifloor = false, bool onlyPlayers = false,
+		void getSpectators(SpectatorVec& spectators, const Position& centerPos, bool multifloor = false, bool onlyPlayers = false,
 		                   int32_t minRangeX = 0, int32_t maxRangeX = 0,
 		                   int32_t minRangeY = 0, int32_t maxRangeY = 0);
 
-		void clearSpectatorCache();
+		// a creature was added to or removed from the tile at pos
+		void invalidateSpectatorCache(const Position& pos);
 
 		/**
 		  * Checks if you can throw an object to that position
@@ -253,11 +393,36 @@ class Map
 
 		bool getPathMatching(const Creature& creature, std::forward_list<Direction>& dirList,
 		                     const FrozenPathingConditionCall& pathCondition, const FindPathParams& fpp) const;
+		// melee chasers of one target share a single search, anything else goes through getPathMatching
+		bool getFollowPath(const Creature& creature, const Position& targetPos, std::forward_list<Direction>& dirList,
+		                   const FindPathParams& fpp);
 
 		std::map<std::string, Position> waypoints;
 
 		QTreeLeafNode* getQTNode(uint16_t x, uint16_t y) {
-			return QTreeNode::getLeafStatic<QTreeLeafNode*, QTreeNode*>(&root, x, y);
+			return findLeaf(x, y);
+		}
+
+		// the tile unless it blocks the path of every creature, see Map::updateTileBits
+		Tile* getPathTile(uint16_t x, uint16_t y, uint8_t z) const;
+		bool isProjectileBlocked(uint16_t x, uint16_t y, uint8_t z) const;
+		// recomputes the path and projectile bits of the tile, called whenever its items change
+		void updateTileBits(const Tile& tile);
+
+		// counts the tiles of the map and the bytes they use, see Tile::getMemoryUsage
+		void getTileMemoryUsage(size_t& tiles, size_t& bytes) const;
+
+		// sets up the dense leaf index for a map of the given size, unless disabled in the config,
+		// must be called before the first tile is set
+		void createLeafIndex(uint32_t mapWidth, uint32_t mapHeight);
+
+		// Builds the tile areas of a lazily loaded map in the region around a position that are
+		// not built yet. Tile lookups do this on their own, it returns false when there were none.
+		bool loadRegion(uint16_t x, uint16_t y, uint8_t z);
+		// builds every region a square around centerPos touches on its floor
+		void loadRegions(const Position& centerPos, int32_t radius);
+		size_t getPendingRegionCount() const {
+			return pendingRegions.size();
 		}
 
 		Spawns spawns;
@@ -265,11 +430,56 @@ class Map
 		Houses houses;
 
 	private:
-		SpectatorCache spectatorCache;
-		SpectatorCache playersSpectatorCache;
+		std::unordered_map<FollowPathKey, FollowPathField, FollowPathKeyHash> followPathFields;
 
 		QTreeNode root;
 
+		// Optional O(1) lookup of the quadtree leaves within the map size from the header, in
+		// chunks of LEAF_CHUNK_SIZE x LEAF_CHUNK_SIZE leaves that are allocated where there are tiles.
+		// Positions outside of it, or every position when it is disabled, walk the tree.
+		struct LeafChunk {
+			QTreeLeafNode* leaves[LEAF_CHUNK_SIZE][LEAF_CHUNK_SIZE] = {};
+		};
+		std::vector<std::unique_ptr<LeafChunk>> leafChunks;
+		uint32_t leafChunksX = 0;
+		uint32_t leafChunksY = 0;
+
+		QTreeLeafNode* findLeaf(uint16_t x, uint16_t y) const {
+			uint32_t chunkX = x >> (FLOOR_BITS + LEAF_CHUNK_BITS);
+			uint32_t chunkY = y >> (FLOOR_BITS + LEAF_CHUNK_BITS);
+			if (chunkX >= leafChunksX || chunkY >= leafChunksY) {
+				return const_cast<QTreeLeafNode*>(QTreeNode::getLeafStatic<const QTreeLeafNode*, const QTreeNode*>(&root, x, y));
+			}
+
+			const LeafChunk* chunk = leafChunks[chunkY * leafChunksX + chunkX].get();
+			if (!chunk) {
+				return nullptr;
+			}
+			return chunk->leaves[(y >> FLOOR_BITS) & LEAF_CHUNK_MASK][(x >> FLOOR_BITS) & LEAF_CHUNK_MASK];
+		}
+		void indexLeaf(uint16_t x, uint16_t y, QTreeLeafNode* leaf);
+
+		// Tile areas of a lazily loaded map that are not built yet, listed for every region they
+		// have tiles in. The map file stays open until the last of them is built.
+		struct PendingTileArea {
+			const OTB::Node* node;
+			bool loaded;
+		};
+		std::unique_ptr<OTB::Loader> regionLoader;
+		std::vector<PendingTileArea> pendingAreas;
+		std::unordered_map<uint32_t, std::vector<size_t>> pendingRegions;
+		// one bit per region, checked whenever a lookup finds no tile
+		std::vector<bool> pendingRegionBits;
+		uint32_t regionLoadDepth = 0;
+
+		static uint32_t getRegionKey(uint16_t x, uint16_t y, uint8_t z) {
+			return (x >> MAP_REGION_BITS) | ((y >> MAP_REGION_BITS) << (16 - MAP_REGION_BITS)) | (z << (2 * (16 - MAP_REGION_BITS)));
+		}
+		bool isRegionPending(uint16_t x, uint16_t y, uint8_t z) const {
+			return !pendingRegionBits.empty() && pendingRegionBits[getRegionKey(x, y, z)];
+		}
+		void addPendingArea(uint16_t x, uint16_t y, uint8_t z, const OTB::Node& node);
+
 		std::string spawnfile;
 		std::string housefile;
 
@@ -277,10 +487,14 @@ class Map
 		uint32_t height = 0;
 
 		// Actually scans the map for spectators
-		void getSpectatorsInternal(SpectatorHashSet& spectators, const Position& centerPos,
+		template<typename Container>
+		void getSpectatorsInternal(Container& spectators, const Position& centerPos,
 		                           int32_t minRangeX, int32_t maxRangeX,
 		                           int32_t minRangeY, int32_t maxRangeY,
 		                           int32_t minRangeZ, int32_t maxRangeZ, bool onlyPlayers) const;
+		const CreaturePositionList& getSpectatorCandidates(QTreeLeafNode& leaf, uint16_t leafX, uint16_t leafY, uint8_t z, bool onlyPlayers);
+
+		void searchFollowPathField(FollowPathField& field, const Monster& monster, const Position& targetPos, bool allowDiagonal) const;
 
 		friend class Game;
 		friend class IOMap;
@@ -365,7 +365,7 @@ void Monster::updateTargetList()
 		}
 	}
 
-	SpectatorHashSet spectators;
+	SpectatorVec spectators;
 	g_game.map.getSpectators(spectators, position, true);
 	spectators.erase(this);
 	for (Creature* spectator : spectators) {
@@ -836,8 +836,8 @@ bool Monster::canUseSpell(const Position& pos, const Position& targetPos,
 	}
 
 	if (extraMeleeAttack) {
-		lastMeleeAttack = OTSYS_TIME();
-	} else if (sb.isMelee && (OTSYS_TIME() - lastMeleeAttack) < 1500) {
+		lastMeleeAttack = OTSYS_CACHED_TIME();
+	} else if (sb.isMelee && (OTSYS_CACHED_TIME() - lastMeleeAttack) < 1500) {
 		return false;
 	}
 
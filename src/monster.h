@@ -20,6 +20,8 @@
 #ifndef FS_MONSTER_H_9F5EEFE64314418CA7DA41D1B9409DD0
 #define FS_MONSTER_H_9F5EEFE64314418CA7DA41D1B9409DD0
 
+#include <unordered_set>
+
 #include "tile.h"
 #include "monsters.h"
 
@@ -73,6 +75,9 @@ class Monster final : public Creature
 		const std::string& getNameDescription() const override {
 			return mType->nameDescription;
 		}
+		const MonsterType* getMonsterType() const {
+			return mType;
+		}
 		std::string getDescription(int32_t) const override {
 			return strDescription + '.';
 		}
@@ -34,6 +34,8 @@
 #include "databasemanager.h"
 #include "scheduler.h"
 #include "databasetasks.h"
+#include "jobpool.h"
+#include "loginqueue.h"
 #include "playercachemanager.h"
 #include "script.h"
 #include <fstream>
@@ -41,6 +43,8 @@
 DatabaseTasks g_databaseTasks;
 Dispatcher g_dispatcher;
 Scheduler g_scheduler;
+JobPool g_jobPool;
+LoginQueue g_loginQueue;
 PlayerCacheManager g_playerCacheManager;
 
 Game g_game;
@@ -93,11 +97,15 @@ int main(int argc, char* argv[])
 		g_databaseTasks.shutdown();
 		g_dispatcher.shutdown();
 		g_playerCacheManager.shutdown();
+		g_jobPool.shutdown();
+		g_loginQueue.shutdown();
 	}
 
 	g_scheduler.join();
 	g_databaseTasks.join();
 	g_dispatcher.join();
+	g_jobPool.join();
+	g_loginQueue.join();
 	std::cout << ">> Saving player items." << std::endl;
 	g_playerCacheManager.flush();
 	g_playerCacheManager.join();
@@ -163,6 +171,13 @@ void mainLoader(int, char*[], ServiceManager* services)
 	}
 #endif
 
+	int32_t jobThreads = g_config.getNumber(ConfigManager::JOB_THREADS);
+	if (jobThreads <= 0) {
+		jobThreads = std::max<int32_t>(1, std::thread::hardware_concurrency());
+	}
+	g_jobPool.start(jobThreads);
+	g_loginQueue.start(std::max<int32_t>(1, g_config.getNumber(ConfigManager::LOGIN_THREADS)));
+
 	//set RSA key
 	try {
 		g_RSA.loadPEM("key.pem");
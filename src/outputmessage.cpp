@@ -23,11 +23,14 @@
 #include "protocol.h"
 #include "lockfree.h"
 #include "scheduler.h"
+#include "configmanager.h"
 
 extern Scheduler g_scheduler;
+extern ConfigManager g_config;
 
 const uint16_t OUTPUTMESSAGE_FREE_LIST_CAPACITY = 2048;
-const std::chrono::milliseconds OUTPUTMESSAGE_AUTOSEND_DELAY {10};
+// classes without a delay wait for the end of the dispatcher batch, but not longer than this
+const std::chrono::milliseconds OUTPUTMESSAGE_MAX_BATCH_DELAY {5};
 
 class OutputMessageAllocator
 {
@@ -37,47 +40,256 @@ class OutputMessageAllocator
 		struct rebind {using other = LockfreePoolingAllocator<U, OUTPUTMESSAGE_FREE_LIST_CAPACITY>;};
 };
 
-void OutputMessagePool::scheduleSendAll()
+namespace {
+
+// buffers are acquired on the dispatcher and released on the network threads
+class OutputBufferClass
+{
+	public:
+		OutputBufferClass(size_t bufferSize, size_t freeListCapacity) : bufferSize(bufferSize), freeList(freeListCapacity) {}
+		~OutputBufferClass() {
+			uint8_t* buffer;
+			while (freeList.pop(buffer)) {
+				delete[] buffer;
+			}
+		}
+
+		// non-copyable
+		OutputBufferClass(const OutputBufferClass&) = delete;
+		OutputBufferClass& operator=(const OutputBufferClass&) = delete;
+
+		uint8_t* acquire() {
+			++acquired;
+			++inUse;
+
+			uint8_t* buffer;
+			if (freeList.pop(buffer)) {
+				++reused;
+				return buffer;
+			}
+			return new uint8_t[bufferSize];
+		}
+
+		void release(uint8_t* buffer) {
+			--inUse;
+			if (!freeList.bounded_push(buffer)) {
+				delete[] buffer;
+			}
+		}
+
+		OutputBufferStats getStats() const {
+			OutputBufferStats stats;
+			stats.bufferSize = bufferSize;
+			stats.acquired = acquired;
+			stats.reused = reused;
+			stats.grown = grown;
+			stats.inUse = inUse;
+			return stats;
+		}
+
+		const size_t bufferSize;
+		std::atomic<uint64_t> grown {0};
+
+	private:
+		boost::lockfree::stack<uint8_t*> freeList;
+		std::atomic<uint64_t> acquired {0};
+		std::atomic<uint64_t> reused {0};
+		std::atomic<uint64_t> inUse {0};
+};
+
+// the largest class has to hold NetworkMessage::MAX_BODY_LENGTH plus the headers
+OutputBufferClass* getBufferClasses()
+{
+	static OutputBufferClass bufferClasses[OUTPUTMESSAGE_SIZE_CLASSES] = {
+		{256, 4096},
+		{2048, 2048},
+		{NETWORKMESSAGE_MAXSIZE, 256},
+	};
+	return bufferClasses;
+}
+
+}
+
+OutputMessage::OutputMessage()
+{
+	OutputBufferClass& bufferClass = getBufferClasses()[sizeClass];
+	buffer = bufferClass.acquire();
+	capacity = bufferClass.bufferSize;
+}
+
+OutputMessage::~OutputMessage()
+{
+	getBufferClasses()[sizeClass].release(buffer);
+}
+
+void OutputMessage::grow(size_t required)
+{
+	OutputBufferClass* bufferClasses = getBufferClasses();
+	bufferClasses[sizeClass].grown++;
+
+	uint8_t newSizeClass = sizeClass + 1;
+	while (bufferClasses[newSizeClass].bufferSize < required) {
+		++newSizeClass;
+	}
+
+	uint8_t* newBuffer = bufferClasses[newSizeClass].acquire();
+	memcpy(newBuffer, buffer, info.position);
+	bufferClasses[sizeClass].release(buffer);
+
+	buffer = newBuffer;
+	capacity = bufferClasses[newSizeClass].bufferSize;
+	sizeClass = newSizeClass;
+}
+
+void OutputMessage::addBytes(const char* bytes, size_t size)
+{
+	if (size > 8192) {
+		return;
+	}
+	write(reinterpret_cast<const uint8_t*>(bytes), size);
+}
+
+void OutputMessage::addPaddingBytes(size_t n)
+{
+	if (!reserve(n)) {
+		return;
+	}
+
+	memset(buffer + info.position, 0x33, n);
+	info.length += n;
+}
+
+void OutputMessage::addString(const std::string& value)
+{
+	size_t stringLen = value.length();
+	if (stringLen > 8192 || !reserve(stringLen + 2)) {
+		return;
+	}
+
+	add<uint16_t>(stringLen);
+	memcpy(buffer + info.position, value.c_str(), stringLen);
+	info.position += stringLen;
+	info.length += stringLen;
+}
+
+namespace {
+
+int64_t getFlushDelay(OutputLatency_t latency)
 {
-	auto functor = std::bind(&OutputMessagePool::sendAll, this);
-	g_scheduler.addEvent(createSchedulerTask(OUTPUTMESSAGE_AUTOSEND_DELAY.count(), functor));
+	int64_t delay;
+	if (latency == OUTPUT_LATENCY_LOW) {
+		delay = g_config.getNumber(ConfigManager::OUTPUT_FLUSH_DELAY_COMBAT);
+	} else {
+		delay = g_config.getNumber(ConfigManager::OUTPUT_FLUSH_DELAY);
+	}
+	return std::max<int64_t>(0, delay);
+}
+
 }
 
-void OutputMessagePool::sendAll()
+void OutputMessagePool::flush(bool endOfBatch)
 {
 	//dispatcher thread
-	for (auto& protocol : bufferedProtocols) {
-		auto& msg = protocol->getCurrentBuffer();
-		if (msg) {
-			protocol->send(std::move(msg));
+	auto now = std::chrono::steady_clock::now();
+	for (size_t latency = 0; latency <= OUTPUT_LATENCY_LAST; ++latency) {
+		DirtyProtocols& dirty = dirtyProtocols[latency];
+		if (dirty.protocols.empty()) {
+			continue;
+		}
+
+		auto waited = now - dirty.since;
+		int64_t delay = getFlushDelay(static_cast<OutputLatency_t>(latency));
+		if (delay == 0) {
+			if (endOfBatch || waited >= OUTPUTMESSAGE_MAX_BATCH_DELAY) {
+				flushLatencyClass(dirty);
+			}
+		} else if (waited >= std::chrono::milliseconds(delay)) {
+			flushLatencyClass(dirty);
 		}
 	}
+}
 
-	if (!bufferedProtocols.empty()) {
-		scheduleSendAll();
+void OutputMessagePool::flushLatencyClass(DirtyProtocols& dirty)
+{
+	//dispatcher thread
+	for (auto& protocol : dirty.protocols) {
+		protocol->autosendQueued = false;
+		protocol->flushOutputBuffer();
 	}
+	dirty.protocols.clear();
 }
 
-void OutputMessagePool::addProtocolToAutosend(Protocol_ptr protocol)
+void OutputMessagePool::scheduleFlush(OutputLatency_t latency, int64_t delay)
+{
+	dirtyProtocols[latency].flushScheduled = true;
+	g_scheduler.addEvent(createSchedulerTask(delay, std::bind(&OutputMessagePool::onFlushEvent, this, latency)));
+}
+
+void OutputMessagePool::onFlushEvent(OutputLatency_t latency)
+{
+	//dispatcher thread
+	DirtyProtocols& dirty = dirtyProtocols[latency];
+	dirty.flushScheduled = false;
+	if (dirty.protocols.empty()) {
+		return;
+	}
+
+	// the class may have been flushed and dirtied again since the event was scheduled
+	auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - dirty.since);
+	int64_t delay = getFlushDelay(latency);
+	if (waited.count() >= delay) {
+		flushLatencyClass(dirty);
+	} else {
+		scheduleFlush(latency, delay - waited.count());
+	}
+}
+
+void OutputMessagePool::addProtocolToAutosend(const Protocol_ptr& protocol)
 {
 	//dispatcher thread
-	if (bufferedProtocols.empty()) {
-		scheduleSendAll();
+	OutputLatency_t latency = protocol->getOutputLatency();
+	DirtyProtocols& dirty = dirtyProtocols[latency];
+	if (dirty.protocols.empty()) {
+		dirty.since = std::chrono::steady_clock::now();
+
+		int64_t delay = getFlushDelay(latency);
+		if (delay != 0 && !dirty.flushScheduled) {
+			scheduleFlush(latency, delay);
+		}
 	}
-	bufferedProtocols.emplace_back(protocol);
+	dirty.protocols.emplace_back(protocol);
 }
 
 void OutputMessagePool::removeProtocolFromAutosend(const Protocol_ptr& protocol)
 {
 	//dispatcher thread
-	auto it = std::find(bufferedProtocols.begin(), bufferedProtocols.end(), protocol);
-	if (it != bufferedProtocols.end()) {
-		std::swap(*it, bufferedProtocols.back());
-		bufferedProtocols.pop_back();
+	for (DirtyProtocols& dirty : dirtyProtocols) {
+		auto it = std::find(dirty.protocols.begin(), dirty.protocols.end(), protocol);
+		if (it != dirty.protocols.end()) {
+			protocol->autosendQueued = false;
+			std::swap(*it, dirty.protocols.back());
+			dirty.protocols.pop_back();
+			return;
+		}
 	}
 }
 
+void OutputMessagePool::recordFlush(OutputMessage::MsgSize_t size, std::chrono::steady_clock::time_point bufferedSince)
+{
+	//dispatcher thread
+	flushSizes.add(size);
+	flushLatencies.add(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - bufferedSince).count());
+}
+
 OutputMessage_ptr OutputMessagePool::getOutputMessage()
 {
 	return std::allocate_shared<OutputMessage>(OutputMessageAllocator());
 }
+
+OutputBufferStats OutputMessagePool::getBufferStats(size_t sizeClass)
+{
+	if (sizeClass >= OUTPUTMESSAGE_SIZE_CLASSES) {
+		return {};
+	}
+	return getBufferClasses()[sizeClass].getStats();
+}
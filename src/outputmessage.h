@@ -26,10 +26,25 @@
 
 class Protocol;
 
-class OutputMessage : public NetworkMessage
+// Outgoing messages start in the smallest buffer class and move to a larger one when a
+// write does not fit, so a ping does not pin a full NETWORKMESSAGE_MAXSIZE buffer.
+static constexpr size_t OUTPUTMESSAGE_SIZE_CLASSES = 3;
+
+struct OutputBufferStats {
+	size_t bufferSize = 0;
+	uint64_t acquired = 0; // buffers handed out in this class
+	uint64_t reused = 0; // of those, taken from the free list
+	uint64_t grown = 0; // messages that outgrew this class
+	uint64_t inUse = 0;
+};
+
+class OutputMessage
 {
 	public:
-		OutputMessage() = default;
+		using MsgSize_t = NetworkMessage::MsgSize_t;
+
+		OutputMessage();
+		~OutputMessage();
 
 		// non-copyable
 		OutputMessage(const OutputMessage&) = delete;
@@ -39,10 +54,41 @@ class OutputMessage : public NetworkMessage
 			return buffer + outputBufferStart;
 		}
 
+		MsgSize_t getLength() const {
+			return info.length;
+		}
+
+		MsgSize_t getBufferPosition() const {
+			return info.position;
+		}
+
+		MsgSize_t getCapacity() const {
+			return capacity;
+		}
+
 		void writeMessageLength() {
 			add_header(info.length);
 		}
 
+		// the high bit of the inner length tells the client that the body is deflated
+		void writeCompressedMessageLength() {
+			add_header(static_cast<MsgSize_t>(info.length | 0x8000));
+		}
+
+		void replaceBody(const uint8_t* bytes, MsgSize_t size) {
+			assert(size <= info.length);
+			memcpy(buffer + outputBufferStart, bytes, size);
+			info.length = size;
+			info.position = outputBufferStart + size;
+		}
+
+		bool isCompressible() const {
+			return compressible;
+		}
+		void setCompressible(bool value) {
+			compressible = value;
+		}
+
 		void addCryptoHeader(bool addChecksum) {
 			if (addChecksum) {
 				add_header(adlerChecksum(buffer + outputBufferStart, info.length));
@@ -51,18 +97,40 @@ class OutputMessage : public NetworkMessage
 			writeMessageLength();
 		}
 
+		void addByte(uint8_t value) {
+			if (!reserve(1)) {
+				return;
+			}
+
+			buffer[info.position++] = value;
+			info.length++;
+		}
+
+		template<typename T>
+		void add(T value) {
+			if (!reserve(sizeof(T))) {
+				return;
+			}
+
+			memcpy(buffer + info.position, &value, sizeof(T));
+			info.position += sizeof(T);
+			info.length += sizeof(T);
+		}
+
+		void addBytes(const char* bytes, size_t size);
+		void addPaddingBytes(size_t n);
+		void addString(const std::string& value);
+
+		void skipBytes(int16_t count) {
+			info.position += count;
+		}
+
 		void append(const NetworkMessage& msg) {
-			auto msgLen = msg.getLength();
-			memcpy(buffer + info.position, msg.getBuffer() + 8, msgLen);
-			info.length += msgLen;
-			info.position += msgLen;
+			write(msg.getBuffer() + NetworkMessage::INITIAL_BUFFER_POSITION, msg.getLength());
 		}
 
 		void append(const OutputMessage_ptr& msg) {
-			auto msgLen = msg->getLength();
-			memcpy(buffer + info.position, msg->getBuffer() + 8, msgLen);
-			info.length += msgLen;
-			info.position += msgLen;
+			write(msg->buffer + NetworkMessage::INITIAL_BUFFER_POSITION, msg->getLength());
 		}
 
 	private:
@@ -75,7 +143,58 @@ class OutputMessage : public NetworkMessage
 			info.length += sizeof(T);
 		}
 
-		MsgSize_t outputBufferStart = INITIAL_BUFFER_POSITION;
+		// same limit as NetworkMessage::canAdd, the buffer grows until it is reached
+		bool reserve(size_t size) {
+			size_t required = size + info.position;
+			if (required >= NetworkMessage::MAX_BODY_LENGTH) {
+				return false;
+			}
+
+			if (required > capacity) {
+				grow(required);
+			}
+			return true;
+		}
+
+		void grow(size_t required);
+
+		void write(const uint8_t* bytes, MsgSize_t size) {
+			if (!reserve(size)) {
+				return;
+			}
+
+			memcpy(buffer + info.position, bytes, size);
+			info.length += size;
+			info.position += size;
+		}
+
+		struct OutputMessageInfo {
+			MsgSize_t length = 0;
+			MsgSize_t position = NetworkMessage::INITIAL_BUFFER_POSITION;
+		};
+
+		OutputMessageInfo info;
+		uint8_t* buffer;
+		MsgSize_t capacity;
+		MsgSize_t outputBufferStart = NetworkMessage::INITIAL_BUFFER_POSITION;
+		uint8_t sizeClass = 0;
+		bool compressible = false;
+};
+
+// bucket 0 counts zeros, bucket i values in [2^(i-1), 2^i), the last one everything above
+struct OutputFlushHistogram {
+	static constexpr size_t BUCKETS = 20;
+
+	std::array<uint64_t, BUCKETS> counts {};
+
+	void add(uint64_t value) {
+		size_t bucket = 0;
+		while (value != 0 && bucket < BUCKETS - 1) {
+			value >>= 1;
+			++bucket;
+		}
+		++counts[bucket];
+	}
 };
 
 class OutputMessagePool
@@ -90,18 +209,45 @@ class OutputMessagePool
 			return instance;
 		}
 
-		void sendAll();
-		void scheduleSendAll();
+		// Sends the buffered output of every latency class whose delay is over. The end of a
+		// dispatcher batch (nothing left to run) also sends the classes without a delay.
+		void flush(bool endOfBatch);
 
 		static OutputMessage_ptr getOutputMessage();
 
-		void addProtocolToAutosend(Protocol_ptr protocol);
+		static OutputBufferStats getBufferStats(size_t sizeClass);
+
+		void addProtocolToAutosend(const Protocol_ptr& protocol);
 		void removeProtocolFromAutosend(const Protocol_ptr& protocol);
+
+		void recordFlush(OutputMessage::MsgSize_t size, std::chrono::steady_clock::time_point bufferedSince);
+
+		// dispatcher thread
+		const OutputFlushHistogram& getFlushSizeHistogram() const {
+			return flushSizes;
+		}
+		const OutputFlushHistogram& getFlushLatencyHistogram() const {
+			return flushLatencies;
+		}
+
 	private:
 		OutputMessagePool() = default;
-		//NOTE: A vector is used here because this container is mostly read
-		//and relatively rarely modified (only when a client connects/disconnects)
-		std::vector<Protocol_ptr> bufferedProtocols;
+
+		struct DirtyProtocols {
+			std::vector<Protocol_ptr> protocols;
+			std::chrono::steady_clock::time_point since;
+			bool flushScheduled = false;
+		};
+
+		void flushLatencyClass(DirtyProtocols& dirty);
+		void scheduleFlush(OutputLatency_t latency, int64_t delay);
+		void onFlushEvent(OutputLatency_t latency);
+
+		//NOTE: only protocols that have buffered output since their last flush are listed
+		std::array<DirtyProtocols, OUTPUT_LATENCY_LAST + 1> dirtyProtocols;
+
+		OutputFlushHistogram flushSizes; // bytes
+		OutputFlushHistogram flushLatencies; // microseconds from the first buffered byte
 };
 
 
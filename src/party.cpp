@@ -415,7 +415,7 @@ bool Party::canUseSharedExperience(const Player* player) const
 			return false;
 		}
 
-		uint64_t timeDiff = OTSYS_TIME() - it->second;
+		uint64_t timeDiff = OTSYS_CACHED_TIME() - it->second;
 		if (timeDiff > static_cast<uint64_t>(g_config.getNumber(ConfigManager::PZ_LOCKED))) {
 			return false;
 		}
@@ -440,7 +440,7 @@ bool Party::canEnableSharedExperience()
 void Party::updatePlayerTicks(Player* player, uint32_t points)
 {
 	if (points != 0 && !player->hasFlag(PlayerFlag_NotGainInFight)) {
-		ticksMap[player->getID()] = OTSYS_TIME();
+		ticksMap[player->getID()] = OTSYS_CACHED_TIME();
 		updateSharedExperience();
 	}
 }
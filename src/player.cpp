@@ -378,8 +378,8 @@ float Player::getAttackFactor() const
 float Player::getDefenseFactor() const
 {
 	switch (fightMode) {
-		case FIGHTMODE_ATTACK: return (OTSYS_TIME() - lastAttack) < getAttackSpeed() ? 0.5f : 1.0f;
-		case FIGHTMODE_BALANCED: return (OTSYS_TIME() - lastAttack) < getAttackSpeed() ? 0.75f : 1.0f;
+		case FIGHTMODE_ATTACK: return (OTSYS_CACHED_TIME() - lastAttack) < getAttackSpeed() ? 0.5f : 1.0f;
+		case FIGHTMODE_BALANCED: return (OTSYS_CACHED_TIME() - lastAttack) < getAttackSpeed() ? 0.75f : 1.0f;
 		case FIGHTMODE_DEFENSE: return 1.0f;
 		default: return 1.0f;
 	}
@@ -714,8 +714,8 @@ bool Player::canWalkthrough(const Creature* creature) const
 	}
 
 	Player* thisPlayer = const_cast<Player*>(this);
-	if ((OTSYS_TIME() - lastWalkthroughAttempt) > 2000) {
-		thisPlayer->setLastWalkthroughAttempt(OTSYS_TIME());
+	if ((OTSYS_CACHED_TIME() - lastWalkthroughAttempt) > 2000) {
+		thisPlayer->setLastWalkthroughAttempt(OTSYS_CACHED_TIME());
 		return false;
 	}
 
@@ -818,7 +818,7 @@ void Player::sendStats()
 
 void Player::sendPing()
 {
-	int64_t timeNow = OTSYS_TIME();
+	int64_t timeNow = OTSYS_CACHED_TIME();
 
 	bool hasLostConnection = false;
 	if ((timeNow - lastPing) >= 5000) {
@@ -1213,7 +1213,7 @@ void Player::onWalk(Direction& dir)
 {
 	Creature::onWalk(dir);
 	setNextActionTask(nullptr);
-	setNextAction(OTSYS_TIME() + getStepDuration(dir));
+	setNextAction(OTSYS_CACHED_TIME() + getStepDuration(dir));
 }
 
 void Player::onCreatureMove(Creature* creature, const Tile* newTile, const Position& newPos,
@@ -1416,7 +1416,7 @@ void Player::setNextActionTask(SchedulerTask* task)
 
 uint32_t Player::getNextActionTime() const
 {
-	return std::max<int64_t>(SCHEDULER_MINTICKS, nextAction - OTSYS_TIME());
+	return std::max<int64_t>(SCHEDULER_MINTICKS, nextAction - OTSYS_CACHED_TIME());
 }
 
 void Player::onThink(uint32_t interval)
@@ -1605,7 +1605,7 @@ void Player::addExperience(Creature* source, uint64_t exp, bool sendText/* = fal
 		message.primary.color = TEXTCOLOR_WHITE_EXP;
 		sendTextMessage(message);
 
-		SpectatorHashSet spectators;
+		SpectatorVec spectators;
 		g_game.map.getSpectators(spectators, position, false, true);
 		spectators.erase(this);
 		if (!spectators.empty()) {
@@ -1688,7 +1688,7 @@ void Player::removeExperience(uint64_t exp, bool sendText/* = false*/)
 		message.primary.color = TEXTCOLOR_RED;
 		sendTextMessage(message);
 
-		SpectatorHashSet spectators;
+		SpectatorVec spectators;
 		g_game.map.getSpectators(spectators, position, false, true);
 		spectators.erase(this);
 		if (!spectators.empty()) {
@@ -1898,7 +1898,7 @@ void Player::death(Creature* lastHitCreature)
 			uint32_t inFightTicks = g_config.getNumber(ConfigManager::PZ_LOCKED);
 			for (const auto& it : damageMap) {
 				CountBlock_t cb = it.second;
-				if ((OTSYS_TIME() - cb.ticks) <= inFightTicks) {
+				if ((OTSYS_CACHED_TIME() - cb.ticks) <= inFightTicks) {
 					Player* damageDealer = g_game.getPlayerByID(it.first);
 					if (damageDealer) {
 						sumLevels += damageDealer->getLevel();
@@ -3127,14 +3127,14 @@ bool Player::setAttackedCreature(Creature* creature)
 void Player::goToFollowCreature()
 {
 	if (!walkTask) {
-		if ((OTSYS_TIME() - lastFailedFollow) < 2000) {
+		if ((OTSYS_CACHED_TIME() - lastFailedFollow) < 2000) {
 			return;
 		}
 
 		Creature::goToFollowCreature();
 
 		if (followCreature && !hasFollowPath) {
-			lastFailedFollow = OTSYS_TIME();
+			lastFailedFollow = OTSYS_CACHED_TIME();
 		}
 	}
 }
@@ -3148,14 +3148,14 @@ void Player::getPathSearchParams(const Creature* creature, FindPathParams& fpp)
 void Player::doAttacking(uint32_t)
 {
 	if (lastAttack == 0) {
-		lastAttack = OTSYS_TIME() - getAttackSpeed() - 1;
+		lastAttack = OTSYS_CACHED_TIME() - getAttackSpeed() - 1;
 	}
 
 	if (hasCondition(CONDITION_PACIFIED)) {
 		return;
 	}
 
-	if ((OTSYS_TIME() - lastAttack) >= getAttackSpeed()) {
+	if ((OTSYS_CACHED_TIME() - lastAttack) >= getAttackSpeed()) {
 		bool result = false;
 
 		Item* tool = getWeapon();
@@ -3183,7 +3183,7 @@ void Player::doAttacking(uint32_t)
 		}
 
 		if (result) {
-			lastAttack = OTSYS_TIME();
+			lastAttack = OTSYS_CACHED_TIME();
 		}
 	}
 }
@@ -3283,6 +3283,10 @@ void Player::onAddCondition(ConditionType_t type)
 		dismount();
 	}
 
+	if (type == CONDITION_INFIGHT && client) {
+		client->setOutputLatency(OUTPUT_LATENCY_LOW);
+	}
+
 	sendIcons();
 }
 
@@ -3335,6 +3339,10 @@ void Player::onEndCondition(ConditionType_t type)
 		pzLocked = false;
 		clearAttacked();
 
+		if (client) {
+			client->setOutputLatency(OUTPUT_LATENCY_NORMAL);
+		}
+
 		if (getSkull() != SKULL_RED && getSkull() != SKULL_BLACK) {
 			setSkull(SKULL_NONE);
 		}
@@ -4088,7 +4096,7 @@ void Player::setCurrentMount(uint8_t mountId)
 
 bool Player::toggleMount(bool mount)
 {
-	if ((OTSYS_TIME() - lastToggleMount) < 3000 && !wasMounted) {
+	if ((OTSYS_CACHED_TIME() - lastToggleMount) < 3000 && !wasMounted) {
 		sendCancelMessage(RETURNVALUE_YOUAREEXHAUSTED);
 		return false;
 	}
@@ -4149,7 +4157,7 @@ bool Player::toggleMount(bool mount)
 	}
 
 	g_game.internalCreatureChangeOutfit(this, defaultOutfit);
-	lastToggleMount = OTSYS_TIME();
+	lastToggleMount = OTSYS_CACHED_TIME();
 	return true;
 }
 
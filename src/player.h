@@ -613,7 +613,7 @@ class Player final : public Creature, public Cylinder
 		                             bool checkDefense = false, bool checkArmor = false, bool field = false) override;
 		void doAttacking(uint32_t interval) override;
 		bool hasExtraSwing() override {
-			return lastAttack > 0 && ((OTSYS_TIME() - lastAttack) >= getAttackSpeed());
+			return lastAttack > 0 && ((OTSYS_CACHED_TIME() - lastAttack) >= getAttackSpeed());
 		}
 
 		uint16_t getSpecialSkill(uint8_t skill) const {
@@ -749,9 +749,9 @@ class Player final : public Creature, public Cylinder
 				client->sendAddCreature(creature, pos, creature->getTile()->getStackposOfCreature(this, creature), isLogin);
 			}
 		}
-		void sendCreatureMove(const Creature* creature, const Position& newPos, int32_t newStackPos, const Position& oldPos, int32_t oldStackPos, bool teleport) {
+		void sendCreatureMove(const Creature* creature, const Position& newPos, int32_t newStackPos, const Position& oldPos, int32_t oldStackPos, bool teleport, const NetworkMessage* moveMessage = nullptr) {
 			if (client) {
-				client->sendMoveCreature(creature, newPos, newStackPos, oldPos, oldStackPos, teleport);
+				client->sendMoveCreature(creature, newPos, newStackPos, oldPos, oldStackPos, teleport, moveMessage);
 			}
 		}
 		void sendCreatureTurn(const Creature* creature) {
@@ -1124,7 +1124,7 @@ class Player final : public Creature, public Cylinder
 		}
 
 		void receivePing() {
-			lastPong = OTSYS_TIME();
+			lastPong = OTSYS_CACHED_TIME();
 		}
 
 		void onThink(uint32_t interval) override;
@@ -1138,7 +1138,7 @@ class Player final : public Creature, public Cylinder
 			}
 		}
 		bool canDoAction() const {
-			return nextAction <= OTSYS_TIME();
+			return nextAction <= OTSYS_CACHED_TIME();
 		}
 		uint32_t getNextActionTime() const;
 
@@ -23,13 +23,19 @@
 #include "outputmessage.h"
 #include "rsa.h"
 #include "xtea.h"
+#include "configmanager.h"
 
 extern RSA g_RSA;
+extern ConfigManager g_config;
 
 void Protocol::onSendMessage(const OutputMessage_ptr& msg) const
 {
 	if (!rawMessages) {
-		msg->writeMessageLength();
+		if (msg->isCompressible() && msg->getLength() >= g_config.getNumber(ConfigManager::PACKET_COMPRESSION_THRESHOLD) && compressor->compress(*msg)) {
+			msg->writeCompressedMessageLength();
+		} else {
+			msg->writeMessageLength();
+		}
 
 		if (encryptionEnabled) {
 			XTEA_encrypt(*msg);
@@ -47,18 +53,51 @@ void Protocol::onRecvMessage(NetworkMessage& msg)
 	parsePacket(msg);
 }
 
+void Protocol::send(OutputMessage_ptr msg) const
+{
+	if (auto connection = getConnection()) {
+		msg->setCompressible(compressionEnabled);
+		connection->send(msg);
+	}
+}
+
+void Protocol::enableCompression(int level)
+{
+	//dispatcher thread, messages are only marked compressible once the compressor exists
+	if (!compressor) {
+		compressor.reset(new PacketCompressor(level));
+		compressionEnabled = true;
+	}
+}
+
 OutputMessage_ptr Protocol::getOutputBuffer(int32_t size)
 {
 	//dispatcher thread
+	if (outputBuffer && (outputBuffer->getLength() + size) > NetworkMessage::MAX_PROTOCOL_BODY_LENGTH) {
+		flushOutputBuffer();
+	}
+
 	if (!outputBuffer) {
 		outputBuffer = OutputMessagePool::getOutputMessage();
-	} else if ((outputBuffer->getLength() + size) > NetworkMessage::MAX_PROTOCOL_BODY_LENGTH) {
-		send(outputBuffer);
-		outputBuffer = OutputMessagePool::getOutputMessage();
+		outputBufferTime = std::chrono::steady_clock::now();
+
+		if (!autosendQueued) {
+			autosendQueued = true;
+			OutputMessagePool::getInstance().addProtocolToAutosend(shared_from_this());
+		}
 	}
 	return outputBuffer;
 }
 
+void Protocol::flushOutputBuffer()
+{
+	//dispatcher thread
+	if (outputBuffer) {
+		OutputMessagePool::getInstance().recordFlush(outputBuffer->getLength(), outputBufferTime);
+		send(std::move(outputBuffer));
+	}
+}
+
 void Protocol::XTEA_encrypt(OutputMessage& msg) const
 {
 	// The message must be a multiple of 8
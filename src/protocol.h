@@ -21,6 +21,7 @@
 #define FS_PROTOCOL_H_D71405071ACF4137A4B1203899DE80E1
 
 #include "connection.h"
+#include "compression.h"
 #include "xtea.h"
 
 class Protocol : public std::enable_shared_from_this<Protocol>
@@ -40,6 +41,11 @@ class Protocol : public std::enable_shared_from_this<Protocol>
 		virtual void onRecvFirstMessage(NetworkMessage& msg) = 0;
 		virtual void onConnect() {}
 
+		// the first message is handled on the login queue instead of the network thread
+		virtual bool usesLoginQueue() const {
+			return false;
+		}
+
 		bool isConnectionExpired() const {
 			return connection.expired();
 		}
@@ -52,17 +58,17 @@ class Protocol : public std::enable_shared_from_this<Protocol>
 
 		//Use this function for autosend messages only
 		OutputMessage_ptr getOutputBuffer(int32_t size);
+		void flushOutputBuffer();
 
-		OutputMessage_ptr& getCurrentBuffer() {
-			return outputBuffer;
+		OutputLatency_t getOutputLatency() const {
+			return outputLatency;
 		}
-
-		void send(OutputMessage_ptr msg) const {
-			if (auto connection = getConnection()) {
-				connection->send(msg);
-			}
+		void setOutputLatency(OutputLatency_t latency) {
+			outputLatency = latency;
 		}
 
+		void send(OutputMessage_ptr msg) const;
+
 	protected:
 		void disconnect() const {
 			if (auto connection = getConnection()) {
@@ -78,6 +84,11 @@ class Protocol : public std::enable_shared_from_this<Protocol>
 		void disableChecksum() {
 			checksumEnabled = false;
 		}
+		// messages sent from now on may be compressed
+		void enableCompression(int level);
+		bool isCompressionEnabled() const {
+			return compressionEnabled;
+		}
 
 		static bool RSA_decrypt(NetworkMessage& msg);
 
@@ -92,8 +103,15 @@ class Protocol : public std::enable_shared_from_this<Protocol>
 		bool XTEA_decrypt(NetworkMessage& msg) const;
 
 		friend class Connection;
+		friend class OutputMessagePool;
 
 		OutputMessage_ptr outputBuffer;
+		std::chrono::steady_clock::time_point outputBufferTime;
+		OutputLatency_t outputLatency = OUTPUT_LATENCY_NORMAL;
+		bool autosendQueued = false;
+
+		std::unique_ptr<PacketCompressor> compressor;
+		std::atomic<bool> compressionEnabled {false};
 
 		const ConnectionWeak_ptr connection;
 		xtea::key key;
@@ -41,6 +41,12 @@ extern Actions actions;
 extern CreatureEvents* g_creatureEvents;
 extern Chat* g_chat;
 
+// sent by OTClient with "deflate" to ask for compressed packets, echoed back once enabled
+const uint8_t EXTENDED_OPCODE_COMPRESSION = 0xFF;
+
+// farthest own-player jump sent as scrolled rows/columns instead of a full map description
+const int32_t MAP_SCROLL_MAX_DISTANCE = 4;
+
 void ProtocolGame::release()
 {
 	//dispatcher thread
@@ -163,7 +169,6 @@ void ProtocolGame::login(const std::string& name, uint32_t accountId, OperatingS
 			connect(foundPlayer->getID(), operatingSystem);
 		}
 	}
-	OutputMessagePool::getInstance().addProtocolToAutosend(shared_from_this());
 }
 
 void ProtocolGame::connect(uint32_t playerId, OperatingSystem_t operatingSystem)
@@ -191,6 +196,9 @@ void ProtocolGame::connect(uint32_t playerId, OperatingSystem_t operatingSystem)
 	player->isConnecting = false;
 
 	player->client = getThis();
+	if (player->hasCondition(CONDITION_INFIGHT)) {
+		setOutputLatency(OUTPUT_LATENCY_LOW);
+	}
 	sendAddCreature(player, player->getPosition(), 0, false);
 	player->lastIP = player->getIP();
 	player->lastLoginSaved = std::max<time_t>(time(nullptr), player->lastLoginSaved + 1);
@@ -261,11 +269,12 @@ void ProtocolGame::onRecvFirstMessage(NetworkMessage& msg)
 	setXTEAKey(std::move(key));
 
 	if (operatingSystem >= CLIENTOS_OTCLIENT_LINUX) {
-		NetworkMessage opcodeMessage;
-		opcodeMessage.addByte(0x32);
-		opcodeMessage.addByte(0x00);
-		opcodeMessage.add<uint16_t>(0x00);
-		writeToOutputBuffer(opcodeMessage);
+		// login queue thread, the autosend buffer belongs to the dispatcher
+		auto output = OutputMessagePool::getOutputMessage();
+		output->addByte(0x32);
+		output->addByte(0x00);
+		output->add<uint16_t>(0x00);
+		send(output);
 	}
 
 	msg.skipBytes(1); // gamemaster flag
@@ -385,6 +394,10 @@ void ProtocolGame::writeToOutputBuffer(const NetworkMessage& msg)
 {
 	auto out = getOutputBuffer(msg.getLength());
 	out->append(msg);
+
+	if (out->getLength() >= g_config.getNumber(ConfigManager::OUTPUT_FLUSH_SIZE)) {
+		flushOutputBuffer();
+	}
 }
 
 void ProtocolGame::parsePacket(NetworkMessage& msg)
@@ -416,34 +429,34 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 	}
 
 	switch (recvbyte) {
-		case 0x14: g_dispatcher.addTask(createTask(std::bind(&ProtocolGame::logout, getThis(), true, false))); break;
-		case 0x1D: addGameTask(&Game::playerReceivePingBack, player->getID()); break;
-		case 0x1E: addGameTask(&Game::playerReceivePing, player->getID()); break;
+		case 0x14: closeGameCommandBatch(); g_dispatcher.addTask(createTask(std::bind(&ProtocolGame::logout, getThis(), true, false))); break;
+		case 0x1D: addGameCommand(GameCommand(GAME_COMMAND_PING_BACK, player->getID())); break;
+		case 0x1E: addGameCommand(GameCommand(GAME_COMMAND_PING, player->getID())); break;
 		case 0x32: parseExtendedOpcode(msg); break; //otclient extended opcode
 		case 0x64: parseAutoWalk(msg); break;
-		case 0x65: addGameTask(&Game::playerMove, player->getID(), DIRECTION_NORTH); break;
-		case 0x66: addGameTask(&Game::playerMove, player->getID(), DIRECTION_EAST); break;
-		case 0x67: addGameTask(&Game::playerMove, player->getID(), DIRECTION_SOUTH); break;
-		case 0x68: addGameTask(&Game::playerMove, player->getID(), DIRECTION_WEST); break;
-		case 0x69: addGameTask(&Game::playerStopAutoWalk, player->getID()); break;
-		case 0x6A: addGameTask(&Game::playerMove, player->getID(), DIRECTION_NORTHEAST); break;
-		case 0x6B: addGameTask(&Game::playerMove, player->getID(), DIRECTION_SOUTHEAST); break;
-		case 0x6C: addGameTask(&Game::playerMove, player->getID(), DIRECTION_SOUTHWEST); break;
-		case 0x6D: addGameTask(&Game::playerMove, player->getID(), DIRECTION_NORTHWEST); break;
-		case 0x6F: addGameTaskTimed(DISPATCHER_TASK_EXPIRATION, &Game::playerTurn, player->getID(), DIRECTION_NORTH); break;
-		case 0x70: addGameTaskTimed(DISPATCHER_TASK_EXPIRATION, &Game::playerTurn, player->getID(), DIRECTION_EAST); break;
-		case 0x71: addGameTaskTimed(DISPATCHER_TASK_EXPIRATION, &Game::playerTurn, player->getID(), DIRECTION_SOUTH); break;
-		case 0x72: addGameTaskTimed(DISPATCHER_TASK_EXPIRATION, &Game::playerTurn, player->getID(), DIRECTION_WEST); break;
+		case 0x65: addGameCommand(GameCommand(GAME_COMMAND_MOVE, player->getID(), DIRECTION_NORTH)); break;
+		case 0x66: addGameCommand(GameCommand(GAME_COMMAND_MOVE, player->getID(), DIRECTION_EAST)); break;
+		case 0x67: addGameCommand(GameCommand(GAME_COMMAND_MOVE, player->getID(), DIRECTION_SOUTH)); break;
+		case 0x68: addGameCommand(GameCommand(GAME_COMMAND_MOVE, player->getID(), DIRECTION_WEST)); break;
+		case 0x69: addGameCommand(GameCommand(GAME_COMMAND_STOP_AUTOWALK, player->getID())); break;
+		case 0x6A: addGameCommand(GameCommand(GAME_COMMAND_MOVE, player->getID(), DIRECTION_NORTHEAST)); break;
+		case 0x6B: addGameCommand(GameCommand(GAME_COMMAND_MOVE, player->getID(), DIRECTION_SOUTHEAST)); break;
+		case 0x6C: addGameCommand(GameCommand(GAME_COMMAND_MOVE, player->getID(), DIRECTION_SOUTHWEST)); break;
+		case 0x6D: addGameCommand(GameCommand(GAME_COMMAND_MOVE, player->getID(), DIRECTION_NORTHWEST)); break;
+		case 0x6F: addGameCommand(GameCommand(GAME_COMMAND_TURN, player->getID(), DISPATCHER_TASK_EXPIRATION, DIRECTION_NORTH)); break;
+		case 0x70: addGameCommand(GameCommand(GAME_COMMAND_TURN, player->getID(), DISPATCHER_TASK_EXPIRATION, DIRECTION_EAST)); break;
+		case 0x71: addGameCommand(GameCommand(GAME_COMMAND_TURN, player->getID(), DISPATCHER_TASK_EXPIRATION, DIRECTION_SOUTH)); break;
+		case 0x72: addGameCommand(GameCommand(GAME_COMMAND_TURN, player->getID(), DISPATCHER_TASK_EXPIRATION, DIRECTION_WEST)); break;
 		case 0x77: parseEquipObject(msg); break;
 		case 0x78: parseThrow(msg); break;
 		case 0x79: parseLookInShop(msg); break;
 		case 0x7A: parsePlayerPurchase(msg); break;
 		case 0x7B: parsePlayerSale(msg); break;
-		case 0x7C: addGameTask(&Game::playerCloseShop, player->getID()); break;
+		case 0x7C: addGameCommand(GameCommand(GAME_COMMAND_CLOSE_SHOP, player->getID())); break;
 		case 0x7D: parseRequestTrade(msg); break;
 		case 0x7E: parseLookInTrade(msg); break;
-		case 0x7F: addGameTask(&Game::playerAcceptTrade, player->getID()); break;
-		case 0x80: addGameTask(&Game::playerCloseTrade, player->getID()); break;
+		case 0x7F: addGameCommand(GameCommand(GAME_COMMAND_ACCEPT_TRADE, player->getID())); break;
+		case 0x80: addGameCommand(GameCommand(GAME_COMMAND_CLOSE_TRADE, player->getID())); break;
 		case 0x82: parseUseItem(msg); break;
 		case 0x83: parseUseItemEx(msg); break;
 		case 0x84: parseUseWithCreature(msg); break;
@@ -456,11 +469,11 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 		case 0x8D: parseLookInBattleList(msg); break;
 		case 0x8E: /* join aggression */ break;
 		case 0x96: parseSay(msg); break;
-		case 0x97: addGameTask(&Game::playerRequestChannels, player->getID()); break;
+		case 0x97: addGameCommand(GameCommand(GAME_COMMAND_REQUEST_CHANNELS, player->getID())); break;
 		case 0x98: parseOpenChannel(msg); break;
 		case 0x99: parseCloseChannel(msg); break;
 		case 0x9A: parseOpenPrivateChannel(msg); break;
-		case 0x9E: addGameTask(&Game::playerCloseNpcChannel, player->getID()); break;
+		case 0x9E: addGameCommand(GameCommand(GAME_COMMAND_CLOSE_NPC_CHANNEL, player->getID())); break;
 		case 0xA0: parseFightModes(msg); break;
 		case 0xA1: parseAttack(msg); break;
 		case 0xA2: parseFollow(msg); break;
@@ -468,17 +481,17 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 		case 0xA4: parseJoinParty(msg); break;
 		case 0xA5: parseRevokePartyInvite(msg); break;
 		case 0xA6: parsePassPartyLeadership(msg); break;
-		case 0xA7: addGameTask(&Game::playerLeaveParty, player->getID()); break;
+		case 0xA7: addGameCommand(GameCommand(GAME_COMMAND_LEAVE_PARTY, player->getID())); break;
 		case 0xA8: parseEnableSharedPartyExperience(msg); break;
-		case 0xAA: addGameTask(&Game::playerCreatePrivateChannel, player->getID()); break;
+		case 0xAA: addGameCommand(GameCommand(GAME_COMMAND_CREATE_PRIVATE_CHANNEL, player->getID())); break;
 		case 0xAB: parseChannelInvite(msg); break;
 		case 0xAC: parseChannelExclude(msg); break;
-		case 0xBE: addGameTask(&Game::playerCancelAttackAndFollow, player->getID()); break;
+		case 0xBE: addGameCommand(GameCommand(GAME_COMMAND_CANCEL_ATTACK_AND_FOLLOW, player->getID())); break;
 		case 0xC9: /* update tile */ break;
 		case 0xCA: parseUpdateContainer(msg); break;
 		case 0xCB: parseBrowseField(msg); break;
 		case 0xCC: parseSeekInContainer(msg); break;
-		case 0xD2: addGameTask(&Game::playerRequestOutfit, player->getID()); break;
+		case 0xD2: addGameCommand(GameCommand(GAME_COMMAND_REQUEST_OUTFIT, player->getID())); break;
 		case 0xD3: parseSetOutfit(msg); break;
 		case 0xD4: parseToggleMount(msg); break;
 		case 0xDC: parseAddVip(msg); break;
@@ -487,7 +500,7 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 		case 0xE6: parseBugReport(msg); break;
 		case 0xE7: /* thank you */ break;
 		case 0xE8: parseDebugAssert(msg); break;
-		case 0xF0: addGameTaskTimed(DISPATCHER_TASK_EXPIRATION, &Game::playerShowQuestLog, player->getID()); break;
+		case 0xF0: addGameCommand(GameCommand(GAME_COMMAND_SHOW_QUEST_LOG, player->getID(), DISPATCHER_TASK_EXPIRATION)); break;
 		case 0xF1: parseQuestLine(msg); break;
 		case 0xF2: parseRuleViolationReport(msg); break;
 		case 0xF3: /* get object info */ break;
@@ -508,6 +521,64 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 	}
 }
 
+void ProtocolGame::addGameCommand(const GameCommand& command)
+{
+	//network thread
+	std::lock_guard<std::mutex> lockClass(gameCommandLock);
+	if (!gameCommandBatch) {
+		gameCommandBatch = std::make_shared<GameCommandBatch>();
+		g_dispatcher.addTask(createTask(std::bind(&ProtocolGame::executeGameCommands, getThis(), gameCommandBatch)));
+	}
+	gameCommandBatch->push_back(command);
+}
+
+void ProtocolGame::closeGameCommandBatch()
+{
+	// packets decoded after this point must not run before the task queued next
+	std::lock_guard<std::mutex> lockClass(gameCommandLock);
+	gameCommandBatch.reset();
+}
+
+void ProtocolGame::executeGameCommands(const GameCommandBatch_ptr& batch)
+{
+	//dispatcher thread
+	{
+		std::lock_guard<std::mutex> lockClass(gameCommandLock);
+		if (gameCommandBatch == batch) {
+			gameCommandBatch.reset();
+		}
+	}
+
+	for (const GameCommand& command : *batch) {
+		if (command.hasExpired()) {
+			continue;
+		}
+
+		executeGameCommand(command);
+	}
+}
+
+void ProtocolGame::executeGameCommand(const GameCommand& command)
+{
+	switch (command.type) {
+		case GAME_COMMAND_PING: g_game.playerReceivePing(command.playerId); break;
+		case GAME_COMMAND_PING_BACK: g_game.playerReceivePingBack(command.playerId); break;
+		case GAME_COMMAND_MOVE: g_game.playerMove(command.playerId, command.direction); break;
+		case GAME_COMMAND_STOP_AUTOWALK: g_game.playerStopAutoWalk(command.playerId); break;
+		case GAME_COMMAND_TURN: g_game.playerTurn(command.playerId, command.direction); break;
+		case GAME_COMMAND_CLOSE_SHOP: g_game.playerCloseShop(command.playerId); break;
+		case GAME_COMMAND_ACCEPT_TRADE: g_game.playerAcceptTrade(command.playerId); break;
+		case GAME_COMMAND_CLOSE_TRADE: g_game.playerCloseTrade(command.playerId); break;
+		case GAME_COMMAND_REQUEST_CHANNELS: g_game.playerRequestChannels(command.playerId); break;
+		case GAME_COMMAND_CLOSE_NPC_CHANNEL: g_game.playerCloseNpcChannel(command.playerId); break;
+		case GAME_COMMAND_LEAVE_PARTY: g_game.playerLeaveParty(command.playerId); break;
+		case GAME_COMMAND_CREATE_PRIVATE_CHANNEL: g_game.playerCreatePrivateChannel(command.playerId); break;
+		case GAME_COMMAND_CANCEL_ATTACK_AND_FOLLOW: g_game.playerCancelAttackAndFollow(command.playerId); break;
+		case GAME_COMMAND_REQUEST_OUTFIT: g_game.playerRequestOutfit(command.playerId); break;
+		case GAME_COMMAND_SHOW_QUEST_LOG: g_game.playerShowQuestLog(command.playerId); break;
+	}
+}
+
 void ProtocolGame::GetTileDescription(const Tile* tile, NetworkMessage& msg)
 {
 	msg.add<uint16_t>(0x00); //environmental effects
@@ -656,6 +727,27 @@ void ProtocolGame::checkCreatureAsKnown(uint32_t id, bool& known, uint32_t& remo
 	}
 }
 
+bool ProtocolGame::canScrollMapDescription(const Position& oldPos, const Position& newPos) const
+{
+	// stairs, ladders and holes: the floor change messages shift the view by one floor
+	if (Position::getDistanceZ(oldPos, newPos) > 1) {
+		return false;
+	}
+
+	int32_t distanceX = Position::getDistanceX(oldPos, newPos);
+	int32_t distanceY = Position::getDistanceY(oldPos, newPos);
+	if (distanceX <= 1 && distanceY <= 1) {
+		return true;
+	}
+
+	// short jumps on the same floor scroll tile by tile, only OTClient is known to accept
+	// the player moving further than one tile at once
+	if (oldPos.z != newPos.z || player->getOperatingSystem() < CLIENTOS_OTCLIENT_LINUX) {
+		return false;
+	}
+	return distanceX <= MAP_SCROLL_MAX_DISTANCE && distanceY <= MAP_SCROLL_MAX_DISTANCE;
+}
+
 bool ProtocolGame::canSee(const Creature* c) const
 {
 	if (!c || !player || c->isRemoved()) {
@@ -1189,9 +1281,7 @@ void ProtocolGame::sendCreatureOutfit(const Creature* creature, const Outfit_t&
 	}
 
 	NetworkMessage msg;
-	msg.addByte(0x8E);
-	msg.add<uint32_t>(creature->getID());
-	AddOutfit(msg, outfit);
+	AddCreatureOutfit(msg, creature, outfit);
 	writeToOutputBuffer(msg);
 }
 
@@ -2132,28 +2222,7 @@ void ProtocolGame::sendCreatureTurn(const Creature* creature, uint32_t stackPos)
 void ProtocolGame::sendCreatureSay(const Creature* creature, SpeakClasses type, const std::string& text, const Position* pos/* = nullptr*/)
 {
 	NetworkMessage msg;
-	msg.addByte(0xAA);
-
-	static uint32_t statementId = 0;
-	msg.add<uint32_t>(++statementId);
-
-	msg.addString(creature->getName());
-
-	//Add level only for players
-	if (const Player* speaker = creature->getPlayer()) {
-		msg.add<uint16_t>(speaker->getLevel());
-	} else {
-		msg.add<uint16_t>(0x00);
-	}
-
-	msg.addByte(type);
-	if (pos) {
-		msg.addPosition(*pos);
-	} else {
-		msg.addPosition(creature->getPosition());
-	}
-
-	msg.addString(text);
+	AddCreatureSay(msg, creature, type, text, pos);
 	writeToOutputBuffer(msg);
 }
 
@@ -2252,10 +2321,7 @@ void ProtocolGame::sendPingBack()
 void ProtocolGame::sendDistanceShoot(const Position& from, const Position& to, uint8_t type)
 {
 	NetworkMessage msg;
-	msg.addByte(0x85);
-	msg.addPosition(from);
-	msg.addPosition(to);
-	msg.addByte(type);
+	AddDistanceShoot(msg, from, to, type);
 	writeToOutputBuffer(msg);
 }
 
@@ -2266,23 +2332,14 @@ void ProtocolGame::sendMagicEffect(const Position& pos, uint8_t type)
 	}
 
 	NetworkMessage msg;
-	msg.addByte(0x83);
-	msg.addPosition(pos);
-	msg.addByte(type);
+	AddMagicEffect(msg, pos, type);
 	writeToOutputBuffer(msg);
 }
 
 void ProtocolGame::sendCreatureHealth(const Creature* creature)
 {
 	NetworkMessage msg;
-	msg.addByte(0x8C);
-	msg.add<uint32_t>(creature->getID());
-
-	if (creature->isHealthHidden()) {
-		msg.addByte(0x00);
-	} else {
-		msg.addByte(std::ceil((static_cast<double>(creature->getHealth()) / std::max<int32_t>(creature->getMaxHealth(), 1)) * 100));
-	}
+	AddCreatureHealth(msg, creature);
 	writeToOutputBuffer(msg);
 }
 
@@ -2468,12 +2525,12 @@ void ProtocolGame::sendAddCreature(const Creature* creature, const Position& pos
 	player->sendIcons();
 }
 
-void ProtocolGame::sendMoveCreature(const Creature* creature, const Position& newPos, int32_t newStackPos, const Position& oldPos, int32_t oldStackPos, bool teleport)
+void ProtocolGame::sendMoveCreature(const Creature* creature, const Position& newPos, int32_t newStackPos, const Position& oldPos, int32_t oldStackPos, bool teleport, const NetworkMessage* moveMessage/* = nullptr*/)
 {
 	if (creature == player) {
 		if (oldStackPos >= 10) {
 			sendMapDescription(newPos);
-		} else if (teleport) {
+		} else if (teleport && !canScrollMapDescription(oldPos, newPos)) {
 			NetworkMessage msg;
 			RemoveTileThing(msg, oldPos, oldStackPos);
 			writeToOutputBuffer(msg);
@@ -2495,20 +2552,24 @@ void ProtocolGame::sendMoveCreature(const Creature* creature, const Position& ne
 				MoveUpCreature(msg, creature, newPos, oldPos);
 			}
 
-			if (oldPos.y > newPos.y) { // north, for old x
+			// one row or column per tile moved, the client shifts its view with each of them
+			// and keeps the part it already knows
+			for (int32_t y = oldPos.y; y > newPos.y; --y) { // north, for old x
 				msg.addByte(0x65);
-				GetMapDescription(oldPos.x - 8, newPos.y - 6, newPos.z, 18, 1, msg);
-			} else if (oldPos.y < newPos.y) { // south, for old x
+				GetMapDescription(oldPos.x - 8, y - 7, newPos.z, 18, 1, msg);
+			}
+			for (int32_t y = oldPos.y; y < newPos.y; ++y) { // south, for old x
 				msg.addByte(0x67);
-				GetMapDescription(oldPos.x - 8, newPos.y + 7, newPos.z, 18, 1, msg);
+				GetMapDescription(oldPos.x - 8, y + 8, newPos.z, 18, 1, msg);
 			}
 
-			if (oldPos.x < newPos.x) { // east, [with new y]
+			for (int32_t x = oldPos.x; x < newPos.x; ++x) { // east, [with new y]
 				msg.addByte(0x66);
-				GetMapDescription(newPos.x + 9, newPos.y - 6, newPos.z, 1, 14, msg);
-			} else if (oldPos.x > newPos.x) { // west, [with new y]
+				GetMapDescription(x + 10, newPos.y - 6, newPos.z, 1, 14, msg);
+			}
+			for (int32_t x = oldPos.x; x > newPos.x; --x) { // west, [with new y]
 				msg.addByte(0x68);
-				GetMapDescription(newPos.x - 8, newPos.y - 6, newPos.z, 1, 14, msg);
+				GetMapDescription(x - 9, newPos.y - 6, newPos.z, 1, 14, msg);
 			}
 			writeToOutputBuffer(msg);
 		}
@@ -2516,12 +2577,11 @@ void ProtocolGame::sendMoveCreature(const Creature* creature, const Position& ne
 		if (teleport || (oldPos.z == 7 && newPos.z >= 8) || oldStackPos >= 10) {
 			sendRemoveTileThing(oldPos, oldStackPos);
 			sendAddCreature(creature, newPos, newStackPos, false);
+		} else if (moveMessage) {
+			writeToOutputBuffer(*moveMessage);
 		} else {
 			NetworkMessage msg;
-			msg.addByte(0x6D);
-			msg.addPosition(oldPos);
-			msg.addByte(oldStackPos);
-			msg.addPosition(creature->getPosition());
+			AddCreatureMove(msg, oldPos, oldStackPos, creature->getPosition());
 			writeToOutputBuffer(msg);
 		}
 	} else if (canSee(oldPos)) {
@@ -2947,6 +3007,74 @@ void ProtocolGame::AddOutfit(NetworkMessage& msg, const Outfit_t& outfit)
 	msg.add<uint16_t>(outfit.lookMount);
 }
 
+void ProtocolGame::AddCreatureHealth(NetworkMessage& msg, const Creature* creature)
+{
+	msg.addByte(0x8C);
+	msg.add<uint32_t>(creature->getID());
+
+	if (creature->isHealthHidden()) {
+		msg.addByte(0x00);
+	} else {
+		msg.addByte(std::ceil((static_cast<double>(creature->getHealth()) / std::max<int32_t>(creature->getMaxHealth(), 1)) * 100));
+	}
+}
+
+void ProtocolGame::AddCreatureOutfit(NetworkMessage& msg, const Creature* creature, const Outfit_t& outfit)
+{
+	msg.addByte(0x8E);
+	msg.add<uint32_t>(creature->getID());
+	AddOutfit(msg, outfit);
+}
+
+void ProtocolGame::AddCreatureSay(NetworkMessage& msg, const Creature* creature, SpeakClasses type, const std::string& text, const Position* pos)
+{
+	msg.addByte(0xAA);
+
+	static uint32_t statementId = 0;
+	msg.add<uint32_t>(++statementId);
+
+	msg.addString(creature->getName());
+
+	//Add level only for players
+	if (const Player* speaker = creature->getPlayer()) {
+		msg.add<uint16_t>(speaker->getLevel());
+	} else {
+		msg.add<uint16_t>(0x00);
+	}
+
+	msg.addByte(type);
+	if (pos) {
+		msg.addPosition(*pos);
+	} else {
+		msg.addPosition(creature->getPosition());
+	}
+
+	msg.addString(text);
+}
+
+void ProtocolGame::AddCreatureMove(NetworkMessage& msg, const Position& oldPos, uint32_t oldStackPos, const Position& newPos)
+{
+	msg.addByte(0x6D);
+	msg.addPosition(oldPos);
+	msg.addByte(oldStackPos);
+	msg.addPosition(newPos);
+}
+
+void ProtocolGame::AddMagicEffect(NetworkMessage& msg, const Position& pos, uint8_t type)
+{
+	msg.addByte(0x83);
+	msg.addPosition(pos);
+	msg.addByte(type);
+}
+
+void ProtocolGame::AddDistanceShoot(NetworkMessage& msg, const Position& from, const Position& to, uint8_t type)
+{
+	msg.addByte(0x85);
+	msg.addPosition(from);
+	msg.addPosition(to);
+	msg.addByte(type);
+}
+
 void ProtocolGame::AddWorldLight(NetworkMessage& msg, LightInfo lightInfo)
 {
 	msg.addByte(0x82);
@@ -3086,6 +3214,31 @@ void ProtocolGame::parseExtendedOpcode(NetworkMessage& msg)
 	uint8_t opcode = msg.getByte();
 	const std::string& buffer = msg.getString();
 
+	if (opcode == EXTENDED_OPCODE_COMPRESSION) {
+		if (buffer == "deflate" && g_config.getBoolean(ConfigManager::PACKET_COMPRESSION)) {
+			g_dispatcher.addTask(createTask(std::bind(&ProtocolGame::startCompression, getThis())));
+		}
+		return;
+	}
+
 	// process additional opcodes via lua script event
 	addGameTask(&Game::parsePlayerExtendedOpcode, player->getID(), opcode, buffer);
 }
+
+void ProtocolGame::startCompression()
+{
+	//dispatcher thread
+	if (isCompressionEnabled() || isConnectionExpired()) {
+		return;
+	}
+
+	// the reply and everything buffered before it still go out uncompressed
+	NetworkMessage msg;
+	msg.addByte(0x32);
+	msg.addByte(EXTENDED_OPCODE_COMPRESSION);
+	msg.addString("deflate");
+	writeToOutputBuffer(msg);
+	flushOutputBuffer();
+
+	enableCompression(g_config.getNumber(ConfigManager::PACKET_COMPRESSION_LEVEL));
+}
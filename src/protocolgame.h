@@ -53,6 +53,46 @@ struct TextMessage
 	TextMessage(MessageClasses type, std::string text) : type(type), text(std::move(text)) {}
 };
 
+enum GameCommand_t : uint8_t {
+	GAME_COMMAND_PING,
+	GAME_COMMAND_PING_BACK,
+	GAME_COMMAND_MOVE,
+	GAME_COMMAND_STOP_AUTOWALK,
+	GAME_COMMAND_TURN,
+	GAME_COMMAND_CLOSE_SHOP,
+	GAME_COMMAND_ACCEPT_TRADE,
+	GAME_COMMAND_CLOSE_TRADE,
+	GAME_COMMAND_REQUEST_CHANNELS,
+	GAME_COMMAND_CLOSE_NPC_CHANNEL,
+	GAME_COMMAND_LEAVE_PARTY,
+	GAME_COMMAND_CREATE_PRIVATE_CHANNEL,
+	GAME_COMMAND_CANCEL_ATTACK_AND_FOLLOW,
+	GAME_COMMAND_REQUEST_OUTFIT,
+	GAME_COMMAND_SHOW_QUEST_LOG,
+};
+
+// Decoded on the network thread for packets that need nothing but the player and a direction
+struct GameCommand
+{
+	GameCommand(GameCommand_t type, uint32_t playerId, Direction direction = DIRECTION_NONE) :
+		playerId(playerId), type(type), direction(direction) {}
+	GameCommand(GameCommand_t type, uint32_t playerId, uint32_t expirationMs, Direction direction = DIRECTION_NONE) :
+		expiration(std::chrono::steady_clock::now() + std::chrono::milliseconds(expirationMs)),
+		playerId(playerId), type(type), direction(direction) {}
+
+	bool hasExpired() const {
+		return expiration != STEADY_TIME_ZERO && expiration < std::chrono::steady_clock::now();
+	}
+
+	std::chrono::steady_clock::time_point expiration = STEADY_TIME_ZERO;
+	uint32_t playerId;
+	GameCommand_t type;
+	Direction direction;
+};
+
+using GameCommandBatch = std::vector<GameCommand>;
+using GameCommandBatch_ptr = std::shared_ptr<GameCommandBatch>;
+
 class ProtocolGame final : public Protocol
 {
 	public:
@@ -73,6 +113,15 @@ class ProtocolGame final : public Protocol
 			return version;
 		}
 
+		// Packets whose bytes do not depend on the receiving client. Code that notifies many
+		// spectators encodes them once and appends the same message to every client.
+		static void AddCreatureHealth(NetworkMessage& msg, const Creature* creature);
+		static void AddCreatureOutfit(NetworkMessage& msg, const Creature* creature, const Outfit_t& outfit);
+		static void AddCreatureSay(NetworkMessage& msg, const Creature* creature, SpeakClasses type, const std::string& text, const Position* pos);
+		static void AddCreatureMove(NetworkMessage& msg, const Position& oldPos, uint32_t oldStackPos, const Position& newPos);
+		static void AddMagicEffect(NetworkMessage& msg, const Position& pos, uint8_t type);
+		static void AddDistanceShoot(NetworkMessage& msg, const Position& from, const Position& to, uint8_t type);
+
 	private:
 		ProtocolGame_ptr getThis() {
 			return std::static_pointer_cast<ProtocolGame>(shared_from_this());
@@ -85,6 +134,8 @@ class ProtocolGame final : public Protocol
 
 		void checkCreatureAsKnown(uint32_t id, bool& known, uint32_t& removedKnown);
 
+		bool canScrollMapDescription(const Position& oldPos, const Position& newPos) const;
+
 		bool canSee(int32_t x, int32_t y, int32_t z) const;
 		bool canSee(const Creature*) const;
 		bool canSee(const Position& pos) const;
@@ -93,6 +144,9 @@ class ProtocolGame final : public Protocol
 		void parsePacket(NetworkMessage& msg) override;
 		void onRecvFirstMessage(NetworkMessage& msg) override;
 		void onConnect() override;
+		bool usesLoginQueue() const override {
+			return true;
+		}
 
 		//Parse methods
 		void parseAutoWalk(NetworkMessage& msg);
@@ -252,7 +306,7 @@ class ProtocolGame final : public Protocol
 
 		void sendAddCreature(const Creature* creature, const Position& pos, int32_t stackpos, bool isLogin);
 		void sendMoveCreature(const Creature* creature, const Position& newPos, int32_t newStackPos,
-		                      const Position& oldPos, int32_t oldStackPos, bool teleport);
+		                      const Position& oldPos, int32_t oldStackPos, bool teleport, const NetworkMessage* moveMessage = nullptr);
 
 		//containers
 		void sendAddContainerItem(uint8_t cid, uint16_t slot, const Item* item);
@@ -284,7 +338,7 @@ class ProtocolGame final : public Protocol
 
 		void AddCreature(NetworkMessage& msg, const Creature* creature, bool known, uint32_t remove);
 		void AddPlayerStats(NetworkMessage& msg);
-		void AddOutfit(NetworkMessage& msg, const Outfit_t& outfit);
+		static void AddOutfit(NetworkMessage& msg, const Outfit_t& outfit);
 		void AddPlayerSkills(NetworkMessage& msg);
 		void AddWorldLight(NetworkMessage& msg, LightInfo lightInfo);
 		void AddCreatureLight(NetworkMessage& msg, const Creature* creature);
@@ -300,23 +354,35 @@ class ProtocolGame final : public Protocol
 
 		//otclient
 		void parseExtendedOpcode(NetworkMessage& msg);
+		void startCompression();
 
 		friend class Player;
 
+		// Commands decoded from consecutive packets share a single dispatcher task
+		void addGameCommand(const GameCommand& command);
+		void closeGameCommandBatch();
+		void executeGameCommands(const GameCommandBatch_ptr& batch);
+		static void executeGameCommand(const GameCommand& command);
+
 		// Helpers so we don't need to bind every time
 		template <typename Callable, typename... Args>
 		void addGameTask(Callable function, Args&&... args) {
+			closeGameCommandBatch();
 			g_dispatcher.addTask(createTask(std::bind(function, &g_game, std::forward<Args>(args)...)));
 		}
 
 		template <typename Callable, typename... Args>
 		void addGameTaskTimed(uint32_t delay, Callable function, Args&&... args) {
+			closeGameCommandBatch();
 			g_dispatcher.addTask(createTask(delay, std::bind(function, &g_game, std::forward<Args>(args)...)));
 		}
 
 		std::unordered_set<uint32_t> knownCreatureSet;
 		Player* player = nullptr;
 
+		GameCommandBatch_ptr gameCommandBatch;
+		std::mutex gameCommandLock;
+
 		uint32_t eventConnect = 0;
 		uint32_t challengeTimestamp = 0;
 		uint16_t version = CLIENT_VERSION_MIN;
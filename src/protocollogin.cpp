@@ -22,7 +22,6 @@
 #include "protocollogin.h"
 
 #include "outputmessage.h"
-#include "tasks.h"
 
 #include "configmanager.h"
 #include "iologindata.h"
@@ -213,6 +212,6 @@ void ProtocolLogin::onRecvFirstMessage(NetworkMessage& msg)
 
 	std::string authToken = msg.getString();
 
-	auto thisPtr = std::static_pointer_cast<ProtocolLogin>(shared_from_this());
-	g_dispatcher.addTask(createTask(std::bind(&ProtocolLogin::getCharacterList, thisPtr, accountName, password, authToken, version)));
+	// still on the login queue, the account queries stay off the dispatcher
+	getCharacterList(accountName, password, authToken, version);
 }
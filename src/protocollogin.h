@@ -39,6 +39,9 @@ class ProtocolLogin : public Protocol
 		explicit ProtocolLogin(Connection_ptr connection) : Protocol(connection) {}
 
 		void onRecvFirstMessage(NetworkMessage& msg) override;
+		bool usesLoginQueue() const override {
+			return true;
+		}
 
 	private:
 		void disconnectClient(const std::string& message, uint16_t version);
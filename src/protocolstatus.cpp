@@ -28,6 +28,11 @@ extern ConfigManager g_config;
 extern Game g_game;
 
 std::map<uint32_t, int64_t> ProtocolStatus::ipConnectMap;
+std::mutex ProtocolStatus::ipConnectMapLock;
+std::shared_ptr<const StatusSnapshot> ProtocolStatus::statusSnapshot;
+std::vector<ProtocolStatus::StatusRequest> ProtocolStatus::pendingStatusRequests;
+std::mutex ProtocolStatus::statusLock;
+bool ProtocolStatus::statusRefreshQueued = false;
 const uint64_t ProtocolStatus::start = OTSYS_TIME();
 
 enum RequestedInfo_t : uint16_t {
@@ -44,25 +49,31 @@ enum RequestedInfo_t : uint16_t {
 void ProtocolStatus::onRecvFirstMessage(NetworkMessage& msg)
 {
 	uint32_t ip = getIP();
-	if (ip != 0x0100007F) {
-		std::string ipStr = convertIPToString(ip);
-		if (ipStr != g_config.getString(ConfigManager::IP)) {
-			std::map<uint32_t, int64_t>::const_iterator it = ipConnectMap.find(ip);
-			if (it != ipConnectMap.end() && (OTSYS_TIME() < (it->second + g_config.getNumber(ConfigManager::STATUSQUERY_TIMEOUT)))) {
-				disconnect();
-				return;
+	{
+		// network threads may serve several status requests at once
+		std::lock_guard<std::mutex> lockClass(ipConnectMapLock);
+		if (ip != 0x0100007F) {
+			std::string ipStr = convertIPToString(ip);
+			if (ipStr != g_config.getString(ConfigManager::IP)) {
+				std::map<uint32_t, int64_t>::const_iterator it = ipConnectMap.find(ip);
+				if (it != ipConnectMap.end() && (OTSYS_TIME() < (it->second + g_config.getNumber(ConfigManager::STATUSQUERY_TIMEOUT)))) {
+					disconnect();
+					return;
+				}
 			}
 		}
-	}
 
-	ipConnectMap[ip] = OTSYS_TIME();
+		ipConnectMap[ip] = OTSYS_TIME();
+	}
 
 	switch (msg.getByte()) {
 		//XML info protocol
 		case 0xFF: {
 			if (msg.getString(4) == "info") {
-				g_dispatcher.addTask(createTask(std::bind(&ProtocolStatus::sendStatusString,
-									  std::static_pointer_cast<ProtocolStatus>(shared_from_this()))));
+				auto thisPtr = std::static_pointer_cast<ProtocolStatus>(shared_from_this());
+				getStatusSnapshot([thisPtr](const StatusSnapshot& status) {
+					thisPtr->sendStatusString(status);
+				});
 				return;
 			}
 			break;
@@ -75,8 +86,10 @@ void ProtocolStatus::onRecvFirstMessage(NetworkMessage& msg)
 			if (requestedInfo & REQUEST_PLAYER_STATUS_INFO) {
 				characterName = msg.getString();
 			}
-			g_dispatcher.addTask(createTask(std::bind(&ProtocolStatus::sendInfo, std::static_pointer_cast<ProtocolStatus>(shared_from_this()),
-								  requestedInfo, characterName)));
+			auto thisPtr = std::static_pointer_cast<ProtocolStatus>(shared_from_this());
+			getStatusSnapshot([thisPtr, requestedInfo, characterName](const StatusSnapshot& status) {
+				thisPtr->sendInfo(status, requestedInfo, characterName);
+			});
 			return;
 		}
 
@@ -86,11 +99,41 @@ void ProtocolStatus::onRecvFirstMessage(NetworkMessage& msg)
 	disconnect();
 }
 
-void ProtocolStatus::sendStatusString()
+void ProtocolStatus::getStatusSnapshot(StatusRequest request)
 {
-	auto output = OutputMessagePool::getOutputMessage();
+	std::shared_ptr<const StatusSnapshot> status;
+	{
+		std::lock_guard<std::mutex> lockClass(statusLock);
+		if (!statusRefreshQueued && (!statusSnapshot || OTSYS_TIME() - statusSnapshot->time >= g_config.getNumber(ConfigManager::STATUS_CACHE_INTERVAL))) {
+			// a stale snapshot is still served, the refresh only affects later requests
+			statusRefreshQueued = true;
+			g_dispatcher.addTask(createTask(&ProtocolStatus::refreshStatusSnapshot));
+		}
 
-	setRawMessages(true);
+		if (!statusSnapshot) {
+			pendingStatusRequests.push_back(std::move(request));
+			return;
+		}
+		status = statusSnapshot;
+	}
+	request(*status);
+}
+
+static std::string getMessageBytes(const NetworkMessage& msg)
+{
+	return {reinterpret_cast<const char*>(msg.getBuffer()) + NetworkMessage::INITIAL_BUFFER_POSITION, msg.getLength()};
+}
+
+void ProtocolStatus::refreshStatusSnapshot()
+{
+	//dispatcher thread
+	auto status = std::make_shared<StatusSnapshot>();
+	status->time = OTSYS_TIME();
+
+	uint64_t uptime = (status->time - ProtocolStatus::start) / 1000;
+
+	uint32_t mapWidth, mapHeight;
+	g_game.getMapDimensions(mapWidth, mapHeight);
 
 	pugi::xml_document doc;
 
@@ -101,7 +144,6 @@ void ProtocolStatus::sendStatusString()
 	tsqp.append_attribute("version") = "1.0";
 
 	pugi::xml_node serverinfo = tsqp.append_child("serverinfo");
-	uint64_t uptime = (OTSYS_TIME() - ProtocolStatus::start) / 1000;
 	serverinfo.append_attribute("uptime") = std::to_string(uptime).c_str();
 	serverinfo.append_attribute("ip") = g_config.getString(ConfigManager::IP).c_str();
 	serverinfo.append_attribute("servername") = g_config.getString(ConfigManager::SERVER_NAME).c_str();
@@ -137,9 +179,6 @@ void ProtocolStatus::sendStatusString()
 	pugi::xml_node map = tsqp.append_child("map");
 	map.append_attribute("name") = g_config.getString(ConfigManager::MAP_NAME).c_str();
 	map.append_attribute("author") = g_config.getString(ConfigManager::MAP_AUTHOR).c_str();
-
-	uint32_t mapWidth, mapHeight;
-	g_game.getMapDimensions(mapWidth, mapHeight);
 	map.append_attribute("width") = std::to_string(mapWidth).c_str();
 	map.append_attribute("height") = std::to_string(mapHeight).c_str();
 
@@ -148,69 +187,119 @@ void ProtocolStatus::sendStatusString()
 
 	std::ostringstream ss;
 	doc.save(ss, "", pugi::format_raw);
+	status->statusString = ss.str();
+
+	NetworkMessage msg;
+	msg.addByte(0x10);
+	msg.addString(g_config.getString(ConfigManager::SERVER_NAME));
+	msg.addString(g_config.getString(ConfigManager::IP));
+	msg.addString(std::to_string(g_config.getNumber(ConfigManager::LOGIN_PORT)));
+	status->basicInfo = getMessageBytes(msg);
+
+	msg.reset();
+	msg.addByte(0x11);
+	msg.addString(g_config.getString(ConfigManager::OWNER_NAME));
+	msg.addString(g_config.getString(ConfigManager::OWNER_EMAIL));
+	status->ownerInfo = getMessageBytes(msg);
+
+	msg.reset();
+	msg.addByte(0x12);
+	msg.addString(g_config.getString(ConfigManager::MOTD));
+	msg.addString(g_config.getString(ConfigManager::LOCATION));
+	msg.addString(g_config.getString(ConfigManager::URL));
+	msg.add<uint64_t>(uptime);
+	status->miscInfo = getMessageBytes(msg);
+
+	msg.reset();
+	msg.addByte(0x20);
+	msg.add<uint32_t>(g_game.getPlayersOnline());
+	msg.add<uint32_t>(g_config.getNumber(ConfigManager::MAX_PLAYERS));
+	msg.add<uint32_t>(g_game.getPlayersRecord());
+	status->playersInfo = getMessageBytes(msg);
+
+	msg.reset();
+	msg.addByte(0x30);
+	msg.addString(g_config.getString(ConfigManager::MAP_NAME));
+	msg.addString(g_config.getString(ConfigManager::MAP_AUTHOR));
+	msg.add<uint16_t>(mapWidth);
+	msg.add<uint16_t>(mapHeight);
+	status->mapInfo = getMessageBytes(msg);
+
+	msg.reset();
+	msg.addByte(0x21); // players info - online players list
+
+	const auto& onlinePlayers = g_game.getPlayers();
+	msg.add<uint32_t>(onlinePlayers.size());
+	status->playerNames.reserve(onlinePlayers.size());
+	for (const auto& it : onlinePlayers) {
+		msg.addString(it.second->getName());
+		msg.add<uint32_t>(it.second->getLevel());
+		status->playerNames.insert(asLowerCaseString(it.second->getName()));
+	}
+	status->extPlayersInfo = getMessageBytes(msg);
+
+	msg.reset();
+	msg.addByte(0x23); // server software info
+	msg.addString(STATUS_SERVER_NAME);
+	msg.addString(STATUS_SERVER_VERSION);
+	msg.addString(CLIENT_VERSION_STR);
+	status->softwareInfo = getMessageBytes(msg);
+
+	std::vector<StatusRequest> requests;
+	{
+		std::lock_guard<std::mutex> lockClass(statusLock);
+		statusSnapshot = status;
+		statusRefreshQueued = false;
+		requests.swap(pendingStatusRequests);
+	}
 
-	std::string data = ss.str();
-	output->addBytes(data.c_str(), data.size());
+	for (const StatusRequest& request : requests) {
+		request(*status);
+	}
+}
+
+void ProtocolStatus::sendStatusString(const StatusSnapshot& status)
+{
+	auto output = OutputMessagePool::getOutputMessage();
+
+	setRawMessages(true);
+
+	output->addBytes(status.statusString.c_str(), status.statusString.size());
 	send(output);
 	disconnect();
 }
 
-void ProtocolStatus::sendInfo(uint16_t requestedInfo, const std::string& characterName)
+void ProtocolStatus::sendInfo(const StatusSnapshot& status, uint16_t requestedInfo, const std::string& characterName)
 {
 	auto output = OutputMessagePool::getOutputMessage();
 
 	if (requestedInfo & REQUEST_BASIC_SERVER_INFO) {
-		output->addByte(0x10);
-		output->addString(g_config.getString(ConfigManager::SERVER_NAME));
-		output->addString(g_config.getString(ConfigManager::IP));
-		output->addString(std::to_string(g_config.getNumber(ConfigManager::LOGIN_PORT)));
+		output->addBytes(status.basicInfo.c_str(), status.basicInfo.size());
 	}
 
 	if (requestedInfo & REQUEST_OWNER_SERVER_INFO) {
-		output->addByte(0x11);
-		output->addString(g_config.getString(ConfigManager::OWNER_NAME));
-		output->addString(g_config.getString(ConfigManager::OWNER_EMAIL));
+		output->addBytes(status.ownerInfo.c_str(), status.ownerInfo.size());
 	}
 
 	if (requestedInfo & REQUEST_MISC_SERVER_INFO) {
-		output->addByte(0x12);
-		output->addString(g_config.getString(ConfigManager::MOTD));
-		output->addString(g_config.getString(ConfigManager::LOCATION));
-		output->addString(g_config.getString(ConfigManager::URL));
-		output->add<uint64_t>((OTSYS_TIME() - ProtocolStatus::start) / 1000);
+		output->addBytes(status.miscInfo.c_str(), status.miscInfo.size());
 	}
 
 	if (requestedInfo & REQUEST_PLAYERS_INFO) {
-		output->addByte(0x20);
-		output->add<uint32_t>(g_game.getPlayersOnline());
-		output->add<uint32_t>(g_config.getNumber(ConfigManager::MAX_PLAYERS));
-		output->add<uint32_t>(g_game.getPlayersRecord());
+		output->addBytes(status.playersInfo.c_str(), status.playersInfo.size());
 	}
 
 	if (requestedInfo & REQUEST_MAP_INFO) {
-		output->addByte(0x30);
-		output->addString(g_config.getString(ConfigManager::MAP_NAME));
-		output->addString(g_config.getString(ConfigManager::MAP_AUTHOR));
-		uint32_t mapWidth, mapHeight;
-		g_game.getMapDimensions(mapWidth, mapHeight);
-		output->add<uint16_t>(mapWidth);
-		output->add<uint16_t>(mapHeight);
+		output->addBytes(status.mapInfo.c_str(), status.mapInfo.size());
 	}
 
 	if (requestedInfo & REQUEST_EXT_PLAYERS_INFO) {
-		output->addByte(0x21); // players info - online players list
-
-		const auto& players = g_game.getPlayers();
-		output->add<uint32_t>(players.size());
-		for (const auto& it : players) {
-			output->addString(it.second->getName());
-			output->add<uint32_t>(it.second->getLevel());
-		}
+		output->addBytes(status.extPlayersInfo.c_str(), status.extPlayersInfo.size());
 	}
 
 	if (requestedInfo & REQUEST_PLAYER_STATUS_INFO) {
 		output->addByte(0x22); // players info - online status info of a player
-		if (g_game.getPlayerByName(characterName) != nullptr) {
+		if (status.playerNames.find(asLowerCaseString(characterName)) != status.playerNames.end()) {
 			output->addByte(0x01);
 		} else {
 			output->addByte(0x00);
@@ -218,10 +307,7 @@ void ProtocolStatus::sendInfo(uint16_t requestedInfo, const std::string& charact
 	}
 
 	if (requestedInfo & REQUEST_SERVER_SOFTWARE_INFO) {
-		output->addByte(0x23); // server software info
-		output->addString(STATUS_SERVER_NAME);
-		output->addString(STATUS_SERVER_VERSION);
-		output->addString(CLIENT_VERSION_STR);
+		output->addBytes(status.softwareInfo.c_str(), status.softwareInfo.size());
 	}
 	send(output);
 	disconnect();
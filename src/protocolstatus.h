@@ -23,6 +23,24 @@
 #include "networkmessage.h"
 #include "protocol.h"
 
+// Status replies are built at most once per statusCacheInterval and shared by all requests
+struct StatusSnapshot {
+	int64_t time = 0;
+
+	std::string statusString;
+
+	std::string basicInfo;
+	std::string ownerInfo;
+	std::string miscInfo;
+	std::string playersInfo;
+	std::string mapInfo;
+	std::string extPlayersInfo;
+	std::string softwareInfo;
+
+	// lower case, for REQUEST_PLAYER_STATUS_INFO
+	std::unordered_set<std::string> playerNames;
+};
+
 class ProtocolStatus final : public Protocol
 {
 	public:
@@ -38,13 +56,25 @@ class ProtocolStatus final : public Protocol
 
 		void onRecvFirstMessage(NetworkMessage& msg) override;
 
-		void sendStatusString();
-		void sendInfo(uint16_t requestedInfo, const std::string& characterName);
+		void sendStatusString(const StatusSnapshot& status);
+		void sendInfo(const StatusSnapshot& status, uint16_t requestedInfo, const std::string& characterName);
 
 		static const uint64_t start;
 
 	private:
+		using StatusRequest = std::function<void (const StatusSnapshot&)>;
+
+		// runs the request on the calling thread, or once the first snapshot exists
+		static void getStatusSnapshot(StatusRequest request);
+		static void refreshStatusSnapshot();
+
+		static std::shared_ptr<const StatusSnapshot> statusSnapshot;
+		static std::vector<StatusRequest> pendingStatusRequests;
+		static std::mutex statusLock;
+		static bool statusRefreshQueued;
+
 		static std::map<uint32_t, int64_t> ipConnectMap;
+		static std::mutex ipConnectMapLock;
 };
 
 #endif
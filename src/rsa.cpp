@@ -27,12 +27,17 @@
 #include <fstream>
 #include <sstream>
 
-static CryptoPP::AutoSeededRandomPool prng;
+// blinding needs randomness, a pool per thread lets handshakes decrypt in parallel
+static CryptoPP::AutoSeededRandomPool& getRandomPool()
+{
+	static thread_local CryptoPP::AutoSeededRandomPool prng;
+	return prng;
+}
 
 void RSA::decrypt(char* msg) const
 {
 	CryptoPP::Integer m{reinterpret_cast<uint8_t*>(msg), 128};
-	auto c = pk.CalculateInverse(prng, m);
+	auto c = pk.CalculateInverse(getRandomPool(), m);
 	c.Encode(reinterpret_cast<uint8_t*>(msg), 128);
 }
 
@@ -70,7 +75,7 @@ void RSA::loadPEM(const std::string& filename)
 	try {
 		pk.BERDecodePrivateKey(queue, false, queue.MaxRetrievable());
 
-		if (!pk.Validate(prng, 3)) {
+		if (!pk.Validate(getRandomPool(), 3)) {
 			throw std::runtime_error("RSA private key is not valid.");
 		}
 	} catch (const CryptoPP::Exception& e) {
@@ -37,6 +37,7 @@ class RSA
 		void decrypt(char* msg) const;
 
 	private:
+		// PKCS#1 key, decryption goes through its CRT parameters (p, q, dp, dq, qInv)
 		CryptoPP::RSA::PrivateKey pk;
 };
 
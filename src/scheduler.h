@@ -38,7 +38,7 @@ class SchedulerTask : public Task
 			return eventId;
 		}
 
-		std::chrono::system_clock::time_point getCycle() const {
+		std::chrono::steady_clock::time_point getCycle() const {
 			return expiration;
 		}
 
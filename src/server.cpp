@@ -36,6 +36,7 @@ ServiceManager::~ServiceManager()
 void ServiceManager::die()
 {
 	io_service.stop();
+	networkThreads.stop();
 }
 
 void ServiceManager::run()
@@ -43,6 +44,68 @@ void ServiceManager::run()
 	assert(!running);
 	running = true;
 	io_service.run();
+	networkThreads.join();
+}
+
+void ServiceManager::startNetworkThreads()
+{
+	if (networkThreads.size() != 0) {
+		return;
+	}
+
+	int32_t threadCount = g_config.getNumber(ConfigManager::NETWORK_THREADS);
+	if (threadCount <= 0) {
+		threadCount = std::max<int32_t>(1, std::thread::hardware_concurrency());
+	}
+	networkThreads.start(threadCount);
+}
+
+NetworkThreadPool::~NetworkThreadPool()
+{
+	stop();
+	join();
+}
+
+void NetworkThreadPool::start(size_t threadCount)
+{
+	threads.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; ++i) {
+		std::unique_ptr<NetworkThread> networkThread(new NetworkThread);
+		networkThread->work.reset(new boost::asio::io_service::work(networkThread->io_service));
+		NetworkThread* thread = networkThread.get();
+		thread->thread = std::thread([thread]() { thread->io_service.run(); });
+		threads.push_back(std::move(networkThread));
+	}
+}
+
+void NetworkThreadPool::stop()
+{
+	for (auto& networkThread : threads) {
+		networkThread->work.reset();
+		networkThread->io_service.stop();
+	}
+}
+
+void NetworkThreadPool::join()
+{
+	for (auto& networkThread : threads) {
+		if (networkThread->thread.joinable()) {
+			networkThread->thread.join();
+		}
+	}
+}
+
+boost::asio::io_service& NetworkThreadPool::getConnectionService(NetworkThreadStats*& threadStats)
+{
+	NetworkThread* best = threads.front().get();
+	for (auto& networkThread : threads) {
+		if (networkThread->stats.connections < best->stats.connections) {
+			best = networkThread.get();
+		}
+	}
+
+	threadStats = &best->stats;
+	return best->io_service;
 }
 
 void ServiceManager::stop()
@@ -98,7 +161,9 @@ void ServicePort::accept()
 		return;
 	}
 
-	auto connection = ConnectionManager::getInstance().createConnection(io_service, shared_from_this());
+	NetworkThreadStats* threadStats;
+	boost::asio::io_service& connectionService = networkThreads.getConnectionService(threadStats);
+	auto connection = ConnectionManager::getInstance().createConnection(connectionService, *threadStats, shared_from_this());
 	acceptor->async_accept(connection->getSocket(), std::bind(&ServicePort::onAccept, shared_from_this(), connection, std::placeholders::_1));
 }
 
@@ -59,10 +59,46 @@ class Service final : public ServiceBase
 		}
 };
 
+class NetworkThreadPool
+{
+	public:
+		NetworkThreadPool() = default;
+		~NetworkThreadPool();
+
+		// non-copyable
+		NetworkThreadPool(const NetworkThreadPool&) = delete;
+		NetworkThreadPool& operator=(const NetworkThreadPool&) = delete;
+
+		void start(size_t threadCount);
+		void stop();
+		void join();
+
+		// connections stay on the thread they were assigned to for their whole lifetime
+		boost::asio::io_service& getConnectionService(NetworkThreadStats*& threadStats);
+
+		size_t size() const {
+			return threads.size();
+		}
+		const NetworkThreadStats& getStats(size_t index) const {
+			return threads[index]->stats;
+		}
+
+	private:
+		struct NetworkThread {
+			boost::asio::io_service io_service;
+			std::unique_ptr<boost::asio::io_service::work> work;
+			std::thread thread;
+			NetworkThreadStats stats;
+		};
+
+		std::vector<std::unique_ptr<NetworkThread>> threads;
+};
+
 class ServicePort : public std::enable_shared_from_this<ServicePort>
 {
 	public:
-		explicit ServicePort(boost::asio::io_service& io_service) : io_service(io_service) {}
+		ServicePort(boost::asio::io_service& io_service, NetworkThreadPool& networkThreads) :
+			io_service(io_service), networkThreads(networkThreads) {}
 		~ServicePort();
 
 		// non-copyable
@@ -85,6 +121,7 @@ class ServicePort : public std::enable_shared_from_this<ServicePort>
 		void accept();
 
 		boost::asio::io_service& io_service;
+		NetworkThreadPool& networkThreads;
 		std::unique_ptr<boost::asio::ip::tcp::acceptor> acceptor;
 		std::vector<Service_ptr> services;
 
@@ -112,12 +149,19 @@ class ServiceManager
 			return acceptors.empty() == false;
 		}
 
+		const NetworkThreadPool& getNetworkThreads() const {
+			return networkThreads;
+		}
+
 	private:
 		void die();
+		void startNetworkThreads();
 
 		std::unordered_map<uint16_t, ServicePort_ptr> acceptors;
 
+		// accepts connections and handles signals, socket I/O runs on networkThreads
 		boost::asio::io_service io_service;
+		NetworkThreadPool networkThreads;
 		Signals signals{io_service};
 		boost::asio::deadline_timer death_timer { io_service };
 		bool running = false;
@@ -131,12 +175,14 @@ bool ServiceManager::add(uint16_t port)
 		return false;
 	}
 
+	startNetworkThreads();
+
 	ServicePort_ptr service_port;
 
 	auto foundServicePort = acceptors.find(port);
 
 	if (foundServicePort == acceptors.end()) {
-		service_port = std::make_shared<ServicePort>(io_service);
+		service_port = std::make_shared<ServicePort>(io_service, networkThreads);
 		service_port->open(port);
 		acceptors[port] = service_port;
 	} else {
@@ -180,7 +180,7 @@ Spawn::~Spawn()
 
 bool Spawn::findPlayer(const Position& pos)
 {
-	SpectatorHashSet spectators;
+	SpectatorVec spectators;
 	g_game.map.getSpectators(spectators, pos, false, true);
 	for (Creature* spectator : spectators) {
 		if (!spectator->getPlayer()->hasFlag(PlayerFlag_IgnoredByMonsters)) {
@@ -216,7 +216,7 @@ bool Spawn::spawnMonster(uint32_t spawnId, MonsterType* mType, const Position& p
 	monster->incrementReferenceCounter();
 
 	spawnedMap.insert(spawned_pair(spawnId, monster));
-	spawnMap[spawnId].lastSpawn = OTSYS_TIME();
+	spawnMap[spawnId].lastSpawn = OTSYS_CACHED_TIME();
 	return true;
 }
 
@@ -244,9 +244,9 @@ void Spawn::checkSpawn()
 		}
 
 		spawnBlock_t& sb = it.second;
-		if (OTSYS_TIME() >= sb.lastSpawn + sb.interval) {
+		if (OTSYS_CACHED_TIME() >= sb.lastSpawn + sb.interval) {
 			if (findPlayer(sb.pos)) {
-				sb.lastSpawn = OTSYS_TIME();
+				sb.lastSpawn = OTSYS_CACHED_TIME();
 				continue;
 			}
 
@@ -270,7 +270,7 @@ void Spawn::cleanup()
 		Monster* monster = it->second;
 		if (monster->isRemoved()) {
 			if (spawnId != 0) {
-				spawnMap[spawnId].lastSpawn = OTSYS_TIME();
+				spawnMap[spawnId].lastSpawn = OTSYS_CACHED_TIME();
 			}
 
 			monster->decrementReferenceCounter();
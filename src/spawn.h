@@ -51,6 +51,12 @@ class Spawn
 		uint32_t getInterval() const {
 			return interval;
 		}
+		const Position& getCenterPos() const {
+			return centerPos;
+		}
+		int32_t getRadius() const {
+			return radius;
+		}
 		void startup();
 
 		void startSpawnCheck();
@@ -92,6 +98,10 @@ class Spawns
 			return started;
 		}
 
+		const std::forward_list<Spawn>& getSpawnList() const {
+			return spawnList;
+		}
+
 	private:
 		std::forward_list<Npc*> npcList;
 		std::forward_list<Spawn> spawnList;
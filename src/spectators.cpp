@@ -0,0 +1,79 @@
+/**
+ * The Forgotten Server - a free and open-source MMORPG server emulator
+ * Copyright (C) 2019  Mark Samman <mark.samman@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "otpch.h"
+
+#include "spectators.h"
+
+static constexpr size_t SPECTATOR_POOL_SIZE = 64;
+
+static std::vector<std::vector<Creature*>>& getFreeVectors()
+{
+	// never destroyed, spectator lists may outlive the thread locals of the main thread
+	static thread_local auto* freeVectors = new std::vector<std::vector<Creature*>>();
+	return *freeVectors;
+}
+
+SpectatorVec::SpectatorVec()
+{
+	auto& freeVectors = getFreeVectors();
+	if (!freeVectors.empty()) {
+		creatures.swap(freeVectors.back());
+		freeVectors.pop_back();
+	}
+}
+
+SpectatorVec::~SpectatorVec()
+{
+	auto& freeVectors = getFreeVectors();
+	if (creatures.capacity() != 0 && freeVectors.size() < SPECTATOR_POOL_SIZE) {
+		creatures.clear();
+		freeVectors.push_back(std::move(creatures));
+	}
+}
+
+SpectatorVec::SpectatorVec(const SpectatorVec& other) : SpectatorVec()
+{
+	creatures.assign(other.creatures.begin(), other.creatures.end());
+}
+
+SpectatorVec& SpectatorVec::operator=(const SpectatorVec& other)
+{
+	if (this != &other) {
+		creatures.assign(other.creatures.begin(), other.creatures.end());
+	}
+	return *this;
+}
+
+void SpectatorVec::insert(Creature* creature)
+{
+	auto it = std::lower_bound(creatures.begin(), creatures.end(), creature);
+	if (it == creatures.end() || *it != creature) {
+		creatures.insert(it, creature);
+	}
+}
+
+void SpectatorVec::erase(Creature* creature)
+{
+	auto it = std::lower_bound(creatures.begin(), creatures.end(), creature);
+	if (it != creatures.end() && *it == creature) {
+		creatures.erase(it);
+	}
+}
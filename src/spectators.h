@@ -0,0 +1,66 @@
+/**
+ * The Forgotten Server - a free and open-source MMORPG server emulator
+ * Copyright (C) 2019  Mark Samman <mark.samman@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef FS_SPECTATORS_H_54B93A0E15284EAF8916B2528CE33B7A
+#define FS_SPECTATORS_H_54B93A0E15284EAF8916B2528CE33B7A
+
+class Creature;
+
+// Result of a spectator query. The creatures are kept sorted by address in a
+// plain vector whose storage is recycled between queries on the same thread.
+class SpectatorVec
+{
+	public:
+		using const_iterator = std::vector<Creature*>::const_iterator;
+
+		SpectatorVec();
+		~SpectatorVec();
+
+		SpectatorVec(const SpectatorVec& other);
+		SpectatorVec& operator=(const SpectatorVec& other);
+
+		const_iterator begin() const {
+			return creatures.begin();
+		}
+		const_iterator end() const {
+			return creatures.end();
+		}
+
+		size_t size() const {
+			return creatures.size();
+		}
+		bool empty() const {
+			return creatures.empty();
+		}
+
+		// does nothing if the creature is already there
+		void insert(Creature* creature);
+		void erase(Creature* creature);
+		void clear() {
+			creatures.clear();
+		}
+
+	private:
+		std::vector<Creature*> creatures;
+
+		friend class Map;
+};
+
+#endif
@@ -20,9 +20,7 @@
 #include "otpch.h"
 
 #include "tasks.h"
-#include "game.h"
-
-extern Game g_game;
+#include "outputmessage.h"
 
 Task* createTask(std::function<void (void)> f)
 {
@@ -44,8 +42,15 @@ void Dispatcher::threadMain()
 		taskLockUnique.lock();
 
 		if (taskList.empty()) {
+			//the batch is done, send what it produced before going idle
+			taskLockUnique.unlock();
+			OutputMessagePool::getInstance().flush(true);
+			taskLockUnique.lock();
+
 			//if the list is empty wait for signal
-			taskSignal.wait(taskLockUnique);
+			if (taskList.empty()) {
+				taskSignal.wait(taskLockUnique);
+			}
 		}
 
 		if (!taskList.empty()) {
@@ -56,10 +61,11 @@ void Dispatcher::threadMain()
 
 			if (!task->hasExpired()) {
 				++dispatcherCycle;
+				updateCachedTime();
 				// execute it
 				(*task)();
 
-				g_game.map.clearSpectatorCache();
+				OutputMessagePool::getInstance().flush(false);
 			}
 			delete task;
 		} else {
@@ -20,10 +20,9 @@
 #ifndef FS_TILE_H_96C7EE7CF8CD48E59D5D554A181F0C56
 #define FS_TILE_H_96C7EE7CF8CD48E59D5D554A181F0C56
 
-#include <unordered_set>
-
 #include "cylinder.h"
 #include "item.h"
+#include "spectators.h"
 #include "tools.h"
 
 class Creature;
@@ -36,7 +35,6 @@ class BedItem;
 
 using CreatureVector = std::vector<Creature*>;
 using ItemVector = std::vector<Item*>;
-using SpectatorHashSet = std::unordered_set<Creature*>;
 
 enum tileflags_t : uint32_t {
 	TILESTATE_NONE = 0,
@@ -77,24 +75,76 @@ enum ZoneType_t {
 	ZONE_NORMAL,
 };
 
-class TileItemVector : private ItemVector
+// Items of a tile, the down items first and then the top items. Most tiles hold one or two
+// items, so the first TILE_INLINE_ITEMS are stored in place and only longer lists allocate.
+static constexpr uint16_t TILE_INLINE_ITEMS = 2;
+
+class TileItemVector
 {
 	public:
-		using ItemVector::begin;
-		using ItemVector::end;
-		using ItemVector::rbegin;
-		using ItemVector::rend;
-		using ItemVector::size;
-		using ItemVector::clear;
-		using ItemVector::at;
-		using ItemVector::insert;
-		using ItemVector::erase;
-		using ItemVector::push_back;
-		using ItemVector::value_type;
-		using ItemVector::iterator;
-		using ItemVector::const_iterator;
-		using ItemVector::reverse_iterator;
-		using ItemVector::const_reverse_iterator;
+		using value_type = Item*;
+		using iterator = Item**;
+		using const_iterator = Item* const*;
+		using reverse_iterator = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+		TileItemVector() = default;
+		~TileItemVector() {
+			if (isAllocated()) {
+				delete[] heapItems;
+			}
+		}
+
+		// non-copyable
+		TileItemVector(const TileItemVector&) = delete;
+		TileItemVector& operator=(const TileItemVector&) = delete;
+
+		iterator begin() {
+			return data();
+		}
+		const_iterator begin() const {
+			return data();
+		}
+		iterator end() {
+			return data() + count;
+		}
+		const_iterator end() const {
+			return data() + count;
+		}
+		reverse_iterator rbegin() {
+			return reverse_iterator(end());
+		}
+		const_reverse_iterator rbegin() const {
+			return const_reverse_iterator(end());
+		}
+		reverse_iterator rend() {
+			return reverse_iterator(begin());
+		}
+		const_reverse_iterator rend() const {
+			return const_reverse_iterator(begin());
+		}
+
+		size_t size() const {
+			return count;
+		}
+		bool empty() const {
+			return count == 0;
+		}
+		void clear() {
+			count = 0;
+		}
+		Item* at(size_t index) const {
+			if (index >= count) {
+				throw std::out_of_range("TileItemVector::at");
+			}
+			return data()[index];
+		}
+
+		iterator insert(const_iterator pos, Item* item);
+		iterator erase(const_iterator pos);
+		void push_back(Item* item) {
+			insert(end(), item);
+		}
 
 		iterator getBeginDownItem() {
 			return begin();
@@ -143,7 +193,29 @@ class TileItemVector : private ItemVector
 			downItemCount += increment;
 		}
 
+		// bytes allocated outside of the object
+		size_t getHeapSize() const {
+			return isAllocated() ? capacity * sizeof(Item*) : 0;
+		}
+
 	private:
+		bool isAllocated() const {
+			return capacity > TILE_INLINE_ITEMS;
+		}
+		Item** data() {
+			return isAllocated() ? heapItems : inlineItems;
+		}
+		Item* const* data() const {
+			return isAllocated() ? heapItems : inlineItems;
+		}
+
+		union {
+			Item* inlineItems[TILE_INLINE_ITEMS];
+			Item** heapItems;
+		};
+		// tiles hold less than 0xFFFF items, see Tile::queryAdd
+		uint16_t count = 0;
+		uint16_t capacity = TILE_INLINE_ITEMS;
 		uint16_t downItemCount = 0;
 };
 
@@ -168,6 +240,9 @@ class Tile : public Cylinder
 		virtual const CreatureVector* getCreatures() const = 0;
 		virtual CreatureVector* makeCreatures() = 0;
 
+		// bytes used by the tile and its lists, not counting the items and creatures themselves
+		virtual size_t getMemoryUsage() const = 0;
+
 		int32_t getThrowRange() const override final {
 			return 0;
 		}
@@ -287,8 +362,8 @@ class Tile : public Cylinder
 	private:
 		void onAddTileItem(Item* item);
 		void onUpdateTileItem(Item* oldItem, const ItemType& oldType, Item* newItem, const ItemType& newType);
-		void onRemoveTileItem(const SpectatorHashSet& spectators, const std::vector<int32_t>& oldStackPosVector, Item* item);
-		void onUpdateTile(const SpectatorHashSet& spectators);
+		void onRemoveTileItem(const SpectatorVec& spectators, const std::vector<int32_t>& oldStackPosVector, Item* item);
+		void onUpdateTile(const SpectatorVec& spectators);
 
 		void setTileFlags(const Item* item);
 		void resetTileFlags(const Item* item);
@@ -302,9 +377,10 @@ class Tile : public Cylinder
 // items being added/removed
 class DynamicTile : public Tile
 {
-		// By allocating the vectors in-house, we avoid some memory fragmentation
+		// The item list is kept in-house, most walkable tiles hold a few items and
+		// its inline storage covers them, while creatures are rare enough to allocate
 		TileItemVector items;
-		CreatureVector creatures;
+		std::unique_ptr<CreatureVector> creatures;
 
 	public:
 		DynamicTile(uint16_t x, uint16_t y, uint8_t z) : Tile(x, y, z) {}
@@ -329,13 +405,29 @@ class DynamicTile : public Tile
 		}
 
 		CreatureVector* getCreatures() override {
-			return &creatures;
+			return creatures.get();
 		}
 		const CreatureVector* getCreatures() const override {
-			return &creatures;
+			return creatures.get();
 		}
 		CreatureVector* makeCreatures() override {
-			return &creatures;
+			if (!creatures) {
+				creatures.reset(new CreatureVector);
+			}
+			return creatures.get();
+		}
+
+		size_t getMemoryUsage() const override {
+			return sizeof(DynamicTile) + getListMemoryUsage();
+		}
+
+	protected:
+		size_t getListMemoryUsage() const {
+			size_t bytes = items.getHeapSize();
+			if (creatures) {
+				bytes += sizeof(CreatureVector) + creatures->capacity() * sizeof(Creature*);
+			}
+			return bytes;
 		}
 };
 
@@ -385,6 +477,17 @@ class StaticTile final : public Tile
 			}
 			return creatures.get();
 		}
+
+		size_t getMemoryUsage() const override {
+			size_t bytes = sizeof(StaticTile);
+			if (items) {
+				bytes += sizeof(TileItemVector) + items->getHeapSize();
+			}
+			if (creatures) {
+				bytes += sizeof(CreatureVector) + creatures->capacity() * sizeof(Creature*);
+			}
+			return bytes;
+		}
 };
 
 #endif
@@ -22,6 +22,13 @@
 #include "tools.h"
 #include "configmanager.h"
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 extern ConfigManager g_config;
 
 void printXMLError(const std::string& where, const std::string& fileName, const pugi::xml_parse_result& result)
@@ -813,18 +820,16 @@ std::string getSkillName(uint8_t skillid)
 	}
 }
 
-uint32_t adlerChecksum(const uint8_t* data, size_t length)
-{
-	if (length > NETWORKMESSAGE_MAXSIZE) {
-		return 0;
-	}
+namespace {
 
-	const uint16_t adler = 65521;
-
-	uint32_t a = 1, b = 0;
+const uint32_t ADLER_BASE = 65521;
+// largest n such that 255n(n+1)/2 + (n+1)(ADLER_BASE-1) fits in 32 bits
+const size_t ADLER_NMAX = 5552;
 
+uint32_t adlerUpdate(uint32_t a, uint32_t b, const uint8_t* data, size_t length)
+{
 	while (length > 0) {
-		size_t tmp = length > 5552 ? 5552 : length;
+		size_t tmp = length > ADLER_NMAX ? ADLER_NMAX : length;
 		length -= tmp;
 
 		do {
@@ -832,13 +837,190 @@ uint32_t adlerChecksum(const uint8_t* data, size_t length)
 			b += a;
 		} while (--tmp);
 
-		a %= adler;
-		b %= adler;
+		a %= ADLER_BASE;
+		b %= ADLER_BASE;
 	}
 
 	return (b << 16) | a;
 }
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ADLER_SIMD
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define ADLER_TARGET(isa)
+#else
+#define ADLER_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// Both kernels consume 32 byte blocks: a accumulates the plain byte sums (psadbw), b the
+// bytes weighted by their distance to the end of the block (pmaddubsw) plus 32 times the
+// value a had before each block. Blocks are grouped so that nothing overflows before the
+// modulo, the remaining bytes go through the scalar loop.
+const size_t ADLER_BLOCK_SIZE = 32;
+
+ADLER_TARGET("ssse3")
+uint32_t adlerChecksumSSSE3(const uint8_t* data, size_t length)
+{
+	uint32_t a = 1, b = 0;
+
+	size_t blocks = length / ADLER_BLOCK_SIZE;
+	length -= blocks * ADLER_BLOCK_SIZE;
+
+	const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+	const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ones = _mm_set1_epi16(1);
+
+	while (blocks > 0) {
+		size_t n = std::min<size_t>(blocks, ADLER_NMAX / ADLER_BLOCK_SIZE);
+		blocks -= n;
+
+		__m128i vPrevA = _mm_cvtsi32_si128(static_cast<int>(a * n));
+		__m128i vB = _mm_cvtsi32_si128(static_cast<int>(b));
+		__m128i vA = _mm_setzero_si128();
+
+		do {
+			const __m128i bytes1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+			const __m128i bytes2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16));
+
+			vPrevA = _mm_add_epi32(vPrevA, vA);
+
+			vA = _mm_add_epi32(vA, _mm_sad_epu8(bytes1, zero));
+			vB = _mm_add_epi32(vB, _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tap1), ones));
+			vA = _mm_add_epi32(vA, _mm_sad_epu8(bytes2, zero));
+			vB = _mm_add_epi32(vB, _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tap2), ones));
+
+			data += ADLER_BLOCK_SIZE;
+		} while (--n);
+
+		vB = _mm_add_epi32(vB, _mm_slli_epi32(vPrevA, 5));
+
+		vA = _mm_add_epi32(vA, _mm_shuffle_epi32(vA, _MM_SHUFFLE(2, 3, 0, 1)));
+		vA = _mm_add_epi32(vA, _mm_shuffle_epi32(vA, _MM_SHUFFLE(1, 0, 3, 2)));
+		vB = _mm_add_epi32(vB, _mm_shuffle_epi32(vB, _MM_SHUFFLE(2, 3, 0, 1)));
+		vB = _mm_add_epi32(vB, _mm_shuffle_epi32(vB, _MM_SHUFFLE(1, 0, 3, 2)));
+
+		a = (a + static_cast<uint32_t>(_mm_cvtsi128_si32(vA))) % ADLER_BASE;
+		b = static_cast<uint32_t>(_mm_cvtsi128_si32(vB)) % ADLER_BASE;
+	}
+
+	return adlerUpdate(a, b, data, length);
+}
+
+ADLER_TARGET("avx2")
+uint32_t adlerChecksumAVX2(const uint8_t* data, size_t length)
+{
+	// two 32 byte vectors per block, so the tap weights run from 64 down to 1
+	const size_t blockSize = 2 * ADLER_BLOCK_SIZE;
+
+	uint32_t a = 1, b = 0;
+
+	size_t blocks = length / blockSize;
+	length -= blocks * blockSize;
+
+	const __m256i tap1 = _mm256_setr_epi8(64, 63, 62, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49,
+	                                      48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33);
+	const __m256i tap2 = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+	                                      16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i ones = _mm256_set1_epi16(1);
+
+	while (blocks > 0) {
+		size_t n = std::min<size_t>(blocks, ADLER_NMAX / blockSize);
+		blocks -= n;
+
+		__m256i vPrevA = _mm256_setr_epi32(static_cast<int>(a * n), 0, 0, 0, 0, 0, 0, 0);
+		__m256i vB = _mm256_setr_epi32(static_cast<int>(b), 0, 0, 0, 0, 0, 0, 0);
+		__m256i vA = _mm256_setzero_si256();
+
+		do {
+			const __m256i bytes1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+			const __m256i bytes2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + ADLER_BLOCK_SIZE));
+
+			vPrevA = _mm256_add_epi32(vPrevA, vA);
+
+			vA = _mm256_add_epi32(vA, _mm256_add_epi32(_mm256_sad_epu8(bytes1, zero), _mm256_sad_epu8(bytes2, zero)));
+			vB = _mm256_add_epi32(vB, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes1, tap1), ones));
+			vB = _mm256_add_epi32(vB, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes2, tap2), ones));
+
+			data += blockSize;
+		} while (--n);
+
+		vB = _mm256_add_epi32(vB, _mm256_slli_epi32(vPrevA, 6));
+
+		__m128i sumA = _mm_add_epi32(_mm256_castsi256_si128(vA), _mm256_extracti128_si256(vA, 1));
+		sumA = _mm_add_epi32(sumA, _mm_shuffle_epi32(sumA, _MM_SHUFFLE(2, 3, 0, 1)));
+		sumA = _mm_add_epi32(sumA, _mm_shuffle_epi32(sumA, _MM_SHUFFLE(1, 0, 3, 2)));
+
+		__m128i sumB = _mm_add_epi32(_mm256_castsi256_si128(vB), _mm256_extracti128_si256(vB, 1));
+		sumB = _mm_add_epi32(sumB, _mm_shuffle_epi32(sumB, _MM_SHUFFLE(2, 3, 0, 1)));
+		sumB = _mm_add_epi32(sumB, _mm_shuffle_epi32(sumB, _MM_SHUFFLE(1, 0, 3, 2)));
+
+		a = (a + static_cast<uint32_t>(_mm_cvtsi128_si32(sumA))) % ADLER_BASE;
+		b = static_cast<uint32_t>(_mm_cvtsi128_si32(sumB)) % ADLER_BASE;
+	}
+
+	return adlerUpdate(a, b, data, length);
+}
+
+using AdlerKernel = uint32_t (*)(const uint8_t*, size_t);
+
+AdlerKernel selectAdlerKernel()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	const int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	const bool ssse3 = (info[2] & (1 << 9)) != 0;
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	if (maxLeaf >= 7 && osxsave && (_xgetbv(0) & 0x6) == 0x6) {
+		__cpuidex(info, 7, 0);
+		if ((info[1] & (1 << 5)) != 0) {
+			return adlerChecksumAVX2;
+		}
+	}
+	if (ssse3) {
+		return adlerChecksumSSSE3;
+	}
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return adlerChecksumAVX2;
+	} else if (__builtin_cpu_supports("ssse3")) {
+		return adlerChecksumSSSE3;
+	}
+#endif
+	return adlerChecksumScalar;
+}
+#endif
+
+}
+
+uint32_t adlerChecksumScalar(const uint8_t* data, size_t length)
+{
+	if (length > NETWORKMESSAGE_MAXSIZE) {
+		return 0;
+	}
+	return adlerUpdate(1, 0, data, length);
+}
+
+uint32_t adlerChecksum(const uint8_t* data, size_t length)
+{
+	if (length > NETWORKMESSAGE_MAXSIZE) {
+		return 0;
+	}
+
+#ifdef ADLER_SIMD
+	static const AdlerKernel kernel = selectAdlerKernel();
+	return kernel(data, length);
+#else
+	return adlerUpdate(1, 0, data, length);
+#endif
+}
+
 std::string ucfirst(std::string str)
 {
 	for (char& i : str) {
@@ -1221,7 +1403,28 @@ const char* getReturnMessage(ReturnValue value)
 
 int64_t OTSYS_TIME()
 {
-	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	// anchored to the wall clock once, then advanced by the steady clock so it never jumps
+	static const int64_t wallClockOffset = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() -
+	                                       std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() + wallClockOffset;
+}
+
+static int64_t cachedTime = 0;
+
+int64_t OTSYS_CACHED_TIME()
+{
+	//dispatcher thread
+#ifdef HIGH_RESOLUTION_GAME_TIME
+	return OTSYS_TIME();
+#else
+	return cachedTime;
+#endif
+}
+
+void updateCachedTime()
+{
+	//dispatcher thread
+	cachedTime = OTSYS_TIME();
 }
 
 SpellGroup_t stringToSpellGroup(std::string value)
@@ -75,6 +75,7 @@ std::string getSpecialSkillName(uint8_t skillid);
 std::string getSkillName(uint8_t skillid);
 
 uint32_t adlerChecksum(const uint8_t* data, size_t length);
+uint32_t adlerChecksumScalar(const uint8_t* data, size_t length);
 
 std::string ucfirst(std::string str);
 std::string ucwords(std::string str);
@@ -93,6 +94,8 @@ itemAttrTypes stringToItemAttribute(const std::string& str);
 const char* getReturnMessage(ReturnValue value);
 
 int64_t OTSYS_TIME();
+int64_t OTSYS_CACHED_TIME();
+void updateCachedTime();
 
 SpellGroup_t stringToSpellGroup(std::string value);
 
@@ -24,6 +24,13 @@
 #include <array>
 #include <assert.h>
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 namespace xtea {
 
 namespace {
@@ -132,9 +139,271 @@ struct XTEA {
 constexpr auto encrypt_v = XTEA<true, InitialBlockSize>();
 constexpr auto decrypt_v = XTEA<false, InitialBlockSize>();
 
+// round keys in the order they are used, the SIMD kernels broadcast one per half round
+using RoundKeys = std::array<uint32_t, 64>;
+
+RoundKeys expandKey(const key& k)
+{
+    RoundKeys roundKeys;
+    uint32_t sum = 0u;
+    for (auto i = 0u; i < 32; ++i) {
+        roundKeys[i * 2] = sum + k[sum & 3];
+        sum += delta;
+        roundKeys[i * 2 + 1] = sum + k[(sum >> 11) & 3];
+    }
+    return roundKeys;
+}
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define XTEA_SIMD
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define XTEA_TARGET(isa)
+#else
+#define XTEA_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// Each kernel runs N blocks at once: the interleaved left/right words of the input are
+// split into one vector of lefts and one of rights, all lanes share the round key.
+
+XTEA_TARGET("sse2")
+void encryptSSE2(uint8_t* data, size_t length, const key& k)
+{
+    const RoundKeys roundKeys = expandKey(k);
+    const auto blocks = length & ~size_t(31);
+    for (size_t i = 0; i < blocks; i += 32) {
+        __m128i a = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i b = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16)), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i left = _mm_unpacklo_epi64(a, b);
+        __m128i right = _mm_unpackhi_epi64(a, b);
+
+        for (auto r = 0u; r < 64; r += 2) {
+            left = _mm_add_epi32(left, _mm_xor_si128(_mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(right, 4), _mm_srli_epi32(right, 5)), right), _mm_set1_epi32(roundKeys[r])));
+            right = _mm_add_epi32(right, _mm_xor_si128(_mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(left, 4), _mm_srli_epi32(left, 5)), left), _mm_set1_epi32(roundKeys[r + 1])));
+        }
+
+        a = _mm_shuffle_epi32(_mm_unpacklo_epi64(left, right), _MM_SHUFFLE(3, 1, 2, 0));
+        b = _mm_shuffle_epi32(_mm_unpackhi_epi64(left, right), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), a);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i + 16), b);
+    }
+    encrypt_v(data + blocks, length - blocks, k);
+}
+
+XTEA_TARGET("sse2")
+void decryptSSE2(uint8_t* data, size_t length, const key& k)
+{
+    const RoundKeys roundKeys = expandKey(k);
+    const auto blocks = length & ~size_t(31);
+    for (size_t i = 0; i < blocks; i += 32) {
+        __m128i a = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i b = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16)), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i left = _mm_unpacklo_epi64(a, b);
+        __m128i right = _mm_unpackhi_epi64(a, b);
+
+        for (auto r = 64u; r > 0; r -= 2) {
+            right = _mm_sub_epi32(right, _mm_xor_si128(_mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(left, 4), _mm_srli_epi32(left, 5)), left), _mm_set1_epi32(roundKeys[r - 1])));
+            left = _mm_sub_epi32(left, _mm_xor_si128(_mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(right, 4), _mm_srli_epi32(right, 5)), right), _mm_set1_epi32(roundKeys[r - 2])));
+        }
+
+        a = _mm_shuffle_epi32(_mm_unpacklo_epi64(left, right), _MM_SHUFFLE(3, 1, 2, 0));
+        b = _mm_shuffle_epi32(_mm_unpackhi_epi64(left, right), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), a);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i + 16), b);
+    }
+    decrypt_v(data + blocks, length - blocks, k);
+}
+
+XTEA_TARGET("avx2")
+void encryptAVX2(uint8_t* data, size_t length, const key& k)
+{
+    const RoundKeys roundKeys = expandKey(k);
+    const auto blocks = length & ~size_t(63);
+    for (size_t i = 0; i < blocks; i += 64) {
+        __m256i a = _mm256_shuffle_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i b = _mm256_shuffle_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32)), _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i left = _mm256_unpacklo_epi64(a, b);
+        __m256i right = _mm256_unpackhi_epi64(a, b);
+
+        for (auto r = 0u; r < 64; r += 2) {
+            left = _mm256_add_epi32(left, _mm256_xor_si256(_mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(right, 4), _mm256_srli_epi32(right, 5)), right), _mm256_set1_epi32(roundKeys[r])));
+            right = _mm256_add_epi32(right, _mm256_xor_si256(_mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(left, 4), _mm256_srli_epi32(left, 5)), left), _mm256_set1_epi32(roundKeys[r + 1])));
+        }
+
+        a = _mm256_shuffle_epi32(_mm256_unpacklo_epi64(left, right), _MM_SHUFFLE(3, 1, 2, 0));
+        b = _mm256_shuffle_epi32(_mm256_unpackhi_epi64(left, right), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), a);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i + 32), b);
+    }
+    encryptSSE2(data + blocks, length - blocks, k);
+}
+
+XTEA_TARGET("avx2")
+void decryptAVX2(uint8_t* data, size_t length, const key& k)
+{
+    const RoundKeys roundKeys = expandKey(k);
+    const auto blocks = length & ~size_t(63);
+    for (size_t i = 0; i < blocks; i += 64) {
+        __m256i a = _mm256_shuffle_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i b = _mm256_shuffle_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32)), _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i left = _mm256_unpacklo_epi64(a, b);
+        __m256i right = _mm256_unpackhi_epi64(a, b);
+
+        for (auto r = 64u; r > 0; r -= 2) {
+            right = _mm256_sub_epi32(right, _mm256_xor_si256(_mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(left, 4), _mm256_srli_epi32(left, 5)), left), _mm256_set1_epi32(roundKeys[r - 1])));
+            left = _mm256_sub_epi32(left, _mm256_xor_si256(_mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(right, 4), _mm256_srli_epi32(right, 5)), right), _mm256_set1_epi32(roundKeys[r - 2])));
+        }
+
+        a = _mm256_shuffle_epi32(_mm256_unpacklo_epi64(left, right), _MM_SHUFFLE(3, 1, 2, 0));
+        b = _mm256_shuffle_epi32(_mm256_unpackhi_epi64(left, right), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), a);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i + 32), b);
+    }
+    decryptSSE2(data + blocks, length - blocks, k);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC warns about the intentionally undefined source operand inside its own AVX-512 intrinsics
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+XTEA_TARGET("avx512f")
+void encryptAVX512(uint8_t* data, size_t length, const key& k)
+{
+    const RoundKeys roundKeys = expandKey(k);
+    const __m512i evenWords = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i oddWords = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    const __m512i lowPairs = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+    const __m512i highPairs = _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+    const auto blocks = length & ~size_t(127);
+    for (size_t i = 0; i < blocks; i += 128) {
+        __m512i a = _mm512_loadu_si512(data + i);
+        __m512i b = _mm512_loadu_si512(data + i + 64);
+        __m512i left = _mm512_permutex2var_epi32(a, evenWords, b);
+        __m512i right = _mm512_permutex2var_epi32(a, oddWords, b);
+
+        for (auto r = 0u; r < 64; r += 2) {
+            left = _mm512_add_epi32(left, _mm512_xor_si512(_mm512_add_epi32(_mm512_xor_si512(_mm512_slli_epi32(right, 4), _mm512_srli_epi32(right, 5)), right), _mm512_set1_epi32(roundKeys[r])));
+            right = _mm512_add_epi32(right, _mm512_xor_si512(_mm512_add_epi32(_mm512_xor_si512(_mm512_slli_epi32(left, 4), _mm512_srli_epi32(left, 5)), left), _mm512_set1_epi32(roundKeys[r + 1])));
+        }
+
+        a = _mm512_permutex2var_epi32(left, lowPairs, right);
+        b = _mm512_permutex2var_epi32(left, highPairs, right);
+        _mm512_storeu_si512(data + i, a);
+        _mm512_storeu_si512(data + i + 64, b);
+    }
+    encryptAVX2(data + blocks, length - blocks, k);
+}
+
+XTEA_TARGET("avx512f")
+void decryptAVX512(uint8_t* data, size_t length, const key& k)
+{
+    const RoundKeys roundKeys = expandKey(k);
+    const __m512i evenWords = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i oddWords = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    const __m512i lowPairs = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+    const __m512i highPairs = _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+    const auto blocks = length & ~size_t(127);
+    for (size_t i = 0; i < blocks; i += 128) {
+        __m512i a = _mm512_loadu_si512(data + i);
+        __m512i b = _mm512_loadu_si512(data + i + 64);
+        __m512i left = _mm512_permutex2var_epi32(a, evenWords, b);
+        __m512i right = _mm512_permutex2var_epi32(a, oddWords, b);
+
+        for (auto r = 64u; r > 0; r -= 2) {
+            right = _mm512_sub_epi32(right, _mm512_xor_si512(_mm512_add_epi32(_mm512_xor_si512(_mm512_slli_epi32(left, 4), _mm512_srli_epi32(left, 5)), left), _mm512_set1_epi32(roundKeys[r - 1])));
+            left = _mm512_sub_epi32(left, _mm512_xor_si512(_mm512_add_epi32(_mm512_xor_si512(_mm512_slli_epi32(right, 4), _mm512_srli_epi32(right, 5)), right), _mm512_set1_epi32(roundKeys[r - 2])));
+        }
+
+        a = _mm512_permutex2var_epi32(left, lowPairs, right);
+        b = _mm512_permutex2var_epi32(left, highPairs, right);
+        _mm512_storeu_si512(data + i, a);
+        _mm512_storeu_si512(data + i + 64, b);
+    }
+    decryptAVX2(data + blocks, length - blocks, k);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+enum class CpuLevel { Scalar, SSE2, AVX2, AVX512 };
+
+CpuLevel detectCpuLevel()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!sse2) {
+        return CpuLevel::Scalar;
+    }
+    if (maxLeaf < 7 || !osxsave) {
+        return CpuLevel::SSE2;
+    }
+
+    // the OS has to save the upper register state for us
+    const unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    if ((info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6) {
+        return CpuLevel::AVX512;
+    }
+    if ((info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6) {
+        return CpuLevel::AVX2;
+    }
+    return CpuLevel::SSE2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return CpuLevel::AVX512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        return CpuLevel::AVX2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        return CpuLevel::SSE2;
+    }
+    return CpuLevel::Scalar;
+#endif
+}
+#endif
+
+using Kernel = void (*)(uint8_t*, size_t, const key&);
+
+struct Kernels {
+    Kernel encrypt = encryptScalar;
+    Kernel decrypt = decryptScalar;
+    const char* name = "scalar";
+
+    Kernels() {
+#ifdef XTEA_SIMD
+        switch (detectCpuLevel()) {
+            case CpuLevel::AVX512: encrypt = encryptAVX512; decrypt = decryptAVX512; name = "AVX-512"; break;
+            case CpuLevel::AVX2: encrypt = encryptAVX2; decrypt = decryptAVX2; name = "AVX2"; break;
+            case CpuLevel::SSE2: encrypt = encryptSSE2; decrypt = decryptSSE2; name = "SSE2"; break;
+            case CpuLevel::Scalar: break;
+        }
+#endif
+    }
+};
+
+const Kernels& kernels()
+{
+    static const Kernels instance;
+    return instance;
+}
+
 } // anonymous namespace
 
-void encrypt(uint8_t* data, size_t length, const key& k) { encrypt_v(data, length, k); }
-void decrypt(uint8_t* data, size_t length, const key& k) { decrypt_v(data, length, k); }
+void encrypt(uint8_t* data, size_t length, const key& k) { kernels().encrypt(data, length, k); }
+void decrypt(uint8_t* data, size_t length, const key& k) { kernels().decrypt(data, length, k); }
+
+void encryptScalar(uint8_t* data, size_t length, const key& k) { encrypt_v(data, length, k); }
+void decryptScalar(uint8_t* data, size_t length, const key& k) { decrypt_v(data, length, k); }
+
+const char* implementation() { return kernels().name; }
 
 } // namespace xtea
@@ -24,9 +24,16 @@ namespace xtea {
 
 using key = std::array<uint32_t, 4>;
 
+// Uses the widest SIMD kernel the CPU supports, selected on first use
 void encrypt(uint8_t* data, size_t length, const key& k);
 void decrypt(uint8_t* data, size_t length, const key& k);
 
+// Portable reference implementation
+void encryptScalar(uint8_t* data, size_t length, const key& k);
+void decryptScalar(uint8_t* data, size_t length, const key& k);
+
+const char* implementation();
+
 } // namespace xtea
 
 #endif // TFS_XTEA_H